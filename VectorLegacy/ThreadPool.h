@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+/*
+Пул потоков для параллельных операций VectorLegacy.
+Потоки создаются один раз и переиспользуются между вызовами run, поэтому
+параллельная операция не платит за создание потоков.
+Вызывающий поток тоже выполняет задачи, так что всего исполнителей size().
+*/
+class ThreadPool {
+private:
+    std::vector<std::thread> m_workers;
+    // Защищает все поля ниже
+    std::mutex m_mutex;
+    // Будит рабочие потоки при появлении новой работы
+    std::condition_variable m_wake;
+    // Будит вызывающий поток, когда все рабочие закончили
+    std::condition_variable m_done;
+    // Текущая работа: task(номер задачи, номер исполнителя)
+    const std::function<void(size_t, size_t)>* m_task;
+    size_t m_count;
+    // Номер следующей свободной задачи
+    std::atomic<size_t> m_next;
+    // Номер поколения работы. Меняется при каждом run
+    size_t m_generation;
+    // Сколько рабочих еще не закончили текущую работу
+    size_t m_active;
+    bool m_stop;
+    // Первое исключение, выброшенное задачей
+    std::exception_ptr m_error;
+    // Один run за раз
+    std::mutex m_run_mutex;
+
+    // Признак того, что текущий поток выполняет задачу пула
+    static bool& inside_pool() {
+        static thread_local bool value = false;
+        return value;
+    }
+
+    // Забираем задачи, пока они не кончатся
+    void execute(size_t worker) {
+        inside_pool() = true;
+        for (size_t i = m_next.fetch_add(1); i < m_count; i = m_next.fetch_add(1)) {
+            try {
+                (*m_task)(i, worker);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_error) {
+                    m_error = std::current_exception();
+                }
+                // Остальные задачи не выполняем
+                m_next = m_count;
+            }
+        }
+        inside_pool() = false;
+    }
+
+    void work(size_t worker) {
+        size_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+                if (m_stop) {
+                    return;
+                }
+                seen = m_generation;
+            }
+            execute(worker);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_active == 0) {
+                m_done.notify_one();
+            }
+        }
+    }
+
+public:
+    explicit ThreadPool(size_t threads) : m_task(nullptr), m_count(0), m_next(0), m_generation(0), m_active(0), m_stop(false) {
+        for (size_t i = 1; i < threads; ++i) {
+            m_workers.emplace_back(&ThreadPool::work, this, i);
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (size_t i = 0; i < m_workers.size(); ++i) {
+            m_workers[i].join();
+        }
+    }
+
+    // Общий пул на все ядра процессора
+    static ThreadPool& instance() {
+        static ThreadPool pool(std::thread::hardware_concurrency() == 0 ? 1 : std::thread::hardware_concurrency());
+        return pool;
+    }
+
+    // Количество исполнителей вместе с вызывающим потоком
+    size_t size() const {
+        return m_workers.size() + 1;
+    }
+
+    // Выполняет task(i, worker) для всех i из [0, count) и ждет завершения.
+    // worker -- номер исполнителя из [0, size()), вызывающий поток имеет номер 0.
+    // Вызов из задачи пула выполняется последовательно в текущем потоке
+    void run(size_t count, const std::function<void(size_t, size_t)>& task) {
+        if (count == 0) {
+            return;
+        }
+        if (m_workers.empty() || count == 1 || inside_pool()) {
+            for (size_t i = 0; i < count; ++i) {
+                task(i, 0);
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> run_lock(m_run_mutex);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_task = &task;
+            m_count = count;
+            m_next = 0;
+            m_active = m_workers.size();
+            m_error = nullptr;
+            ++m_generation;
+        }
+        m_wake.notify_all();
+        execute(0);
+
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [&] { return m_active == 0; });
+            m_task = nullptr;
+            error = m_error;
+            m_error = nullptr;
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
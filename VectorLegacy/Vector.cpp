@@ -1,8 +1,23 @@
 ﻿#include "VectorLegacy.h"
+#include "VectorBenchmark.h"
+#include "VectorLegacyBool.h"
+#include "VectorLegacyExternal.h"
+#include "VectorLegacyCompressed.h"
+#include "VectorLegacySoA.h"
 #include <vector>
-int main() 
+int main(int argc, char* argv[]) 
 {
 	test();
+	test_kernels();
+	test_soa();
+	test_compressed();
+	test_bool();
+	test_external();
+	if (argc > 1 && string(argv[1]) == "bench")
+	{
+		benchmark();
+		return 0;
+	}
 	VectorLegacy<int> arr(5,1);
 	VectorLegacy<string> arr3;
 	VectorLegacy<int> arr2(5, 1);
@@ -0,0 +1,420 @@
+#pragma once
+#include "VectorLegacy.h"
+#include "VectorLegacyCompressed.h"
+#include "VectorLegacyExternal.h"
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <psapi.h>
+#endif
+
+//Пиковый объем резидентной памяти процесса в мегабайтах
+size_t peak_rss_mb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return 0;
+    }
+    return pmc.PeakWorkingSetSize / (1024 * 1024);
+#else
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return stoul(line.substr(6)) / 1024;
+        }
+    }
+    return 0;
+#endif
+}
+
+//Сброс пикового значения, чтобы замеры не влияли друг на друга. На Windows пик не сбрасывается
+void reset_peak_rss() {
+#ifdef __linux__
+    ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+#endif
+}
+
+//Объем анонимной памяти процесса на больших страницах в мегабайтах (только Linux)
+size_t huge_pages_mb() {
+#ifdef __linux__
+    ifstream status("/proc/self/smaps_rollup");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 14, "AnonHugePages:") == 0) {
+            return stoul(line.substr(14)) / 1024;
+        }
+    }
+#endif
+    return 0;
+}
+
+//Время выполнения f в миллисекундах
+template <typename F>
+double measure_ms(F f) {
+    auto start = chrono::steady_clock::now();
+    f();
+    auto stop = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(stop - start).count();
+}
+
+//Рост массива из n элементов через push_back: время и пиковая память.
+//Для сравнения -- std::vector, который при каждом росте копирует весь буфер
+void benchmark_growth(size_t n) {
+    cout << "growth, " << n << " doubles (" << n * sizeof(double) / (1024 * 1024) << " MB)" << endl;
+
+    reset_peak_rss();
+    size_t base = peak_rss_mb();
+    double legacy_ms = measure_ms([n]() {
+        VectorLegacy<double> v;
+        for (size_t i = 0; i < n; ++i) {
+            v.push_back((double)i);
+        }
+    });
+    cout << "  VectorLegacy: " << legacy_ms << " ms, peak +" << peak_rss_mb() - base << " MB" << endl;
+
+    reset_peak_rss();
+    base = peak_rss_mb();
+    double std_ms = measure_ms([n]() {
+        vector<double> v;
+        for (size_t i = 0; i < n; ++i) {
+            v.push_back((double)i);
+        }
+    });
+    cout << "  std::vector:  " << std_ms << " ms, peak +" << peak_rss_mb() - base << " MB" << endl;
+}
+
+//Выбор k наименьших/наибольших из n случайных чисел против полной сортировки
+void benchmark_selection(size_t n) {
+    cout << "selection, " << n << " ints" << endl;
+    VectorLegacy<int> source;
+    srand(42);
+    for (size_t i = 0; i < n; ++i) {
+        source.push_back((int)(((unsigned)rand() << 15) ^ (unsigned)rand()));
+    }
+
+    VectorLegacy<int> copy(source);
+    cout << "  sort:             " << measure_ms([&]() { copy.sort(); }) << " ms" << endl;
+    copy = source;
+    cout << "  nth_element(n/2): " << measure_ms([&]() { copy.nth_element(n / 2); }) << " ms" << endl;
+
+    size_t ks[] = { 10, 100, 10000, 1000000 };
+    for (size_t k : ks) {
+        if (k > n) {
+            break;
+        }
+        copy = source;
+        double partial_ms = measure_ms([&]() { copy.partial_sort(k); });
+        VectorLegacy<int> out;
+        double top_ms = measure_ms([&]() { source.top_k(k, out); });
+        cout << "  k = " << k << ": partial_sort " << partial_ms << " ms, top_k " << top_ms << " ms" << endl;
+    }
+}
+
+//Сортировка почти отсортированного массива: пачки по возрастанию с редкими выбросами.
+//Для сравнения -- сортировка слиянием, которая не использует готовые серии
+void benchmark_presorted(size_t n) {
+    cout << "presorted sort, " << n << " ints" << endl;
+    VectorLegacy<int> source;
+    srand(42);
+    for (size_t i = 0; i < n; ++i) {
+        source.push_back(i % 100000 == 99999 ? rand() : (int)i);
+    }
+    VectorLegacy<int> adaptive(source);
+    VectorLegacy<int> merged(source);
+    cout << "  sort:       " << measure_ms([&]() { adaptive.sort(); }) << " ms" << endl;
+    cout << "  sort_merge: " << measure_ms([&]() { merged.sort_merge(0, n - 1); }) << " ms" << endl;
+}
+
+//Замер задержки каждого push_back: гистограмма по порядкам, p99.99 и максимум.
+//Sample не тривиально конструируется, поэтому его буфер растет копированием, а не через mremap
+struct Sample {
+    double value;
+    Sample() {
+    }
+    Sample(double v) : value(v) {
+    }
+};
+
+void push_back_latency(size_t n, size_t step) {
+    VectorLegacy<Sample> v;
+    if (step != 0) {
+        v.enable_incremental_growth(step);
+    }
+    vector<double> latency(n);
+    for (size_t i = 0; i < n; ++i) {
+        auto start = chrono::steady_clock::now();
+        v.push_back(Sample((double)i));
+        auto stop = chrono::steady_clock::now();
+        latency[i] = chrono::duration<double, micro>(stop - start).count();
+    }
+
+    const char* labels[] = { "<1us", "<10us", "<100us", "<1ms", "<10ms", ">=10ms" };
+    size_t buckets[6] = { 0, 0, 0, 0, 0, 0 };
+    for (size_t i = 0; i < n; ++i) {
+        size_t b = 0;
+        for (double bound = 1; b < 5 && latency[i] >= bound; bound *= 10) {
+            ++b;
+        }
+        ++buckets[b];
+    }
+    cout << "  " << (step == 0 ? "copy at once" : "incremental, step " + std::to_string(step)) << ":";
+    for (size_t b = 0; b < 6; ++b) {
+        cout << " " << labels[b] << " " << buckets[b];
+    }
+    nth_element(latency.begin(), latency.begin() + (n - n / 10000), latency.end());
+    double p9999 = latency[n - n / 10000];
+    cout << ", p99.99 " << p9999 << " us, max " << *max_element(latency.begin(), latency.end()) << " us" << endl;
+}
+
+//Задержка push_back при росте: перенос целиком против постепенного
+void benchmark_latency(size_t n) {
+    cout << "push_back latency, " << n << " samples" << endl;
+    push_back_latency(n, 0);
+    push_back_latency(n, 4096);
+}
+
+//Поиск в неотсортированном массиве: последовательный против хеш-индекса
+void benchmark_index(size_t n, size_t lookups) {
+    cout << "index, " << n << " unsorted ints, " << lookups << " lookups" << endl;
+    VectorLegacy<int> values;
+    srand(42);
+    for (size_t i = 0; i < n; ++i) {
+        values.push_back((int)(((unsigned)rand() << 15) ^ (unsigned)rand()));
+    }
+    VectorLegacy<int> queries;
+    for (size_t i = 0; i < lookups; ++i) {
+        queries.push_back(values[(size_t)rand() % n]);
+    }
+
+    size_t found = 0;
+    double sequential_ms = measure_ms([&]() {
+        for (size_t i = 0; i < lookups; ++i) {
+            found += values.seek(queries[i]) != n;
+        }
+    });
+    values.enable_index();
+    double build_ms = measure_ms([&]() { values.seek(0); });
+    double indexed_ms = measure_ms([&]() {
+        for (size_t i = 0; i < lookups; ++i) {
+            found += values.seek(queries[i]) != n;
+        }
+    });
+    cout << "  seek: sequential " << sequential_ms * 1000000 / lookups << " ns, indexed "
+        << indexed_ms * 1000000 / lookups << " ns (build " << build_ms << " ms, found " << found << ")" << endl;
+}
+
+//Внешняя сортировка n случайных чисел с лимитом памяти memory_mb: сброс серий и слияние
+void benchmark_external(size_t n, size_t memory_mb) {
+    cout << "external sort, " << n << " ints (" << n * sizeof(int) / (1024 * 1024) << " MB), memory "
+        << memory_mb << " MB" << endl;
+    VectorLegacyExternalSort<int> sorter(memory_mb * 1024 * 1024);
+    srand(42);
+    double spill_ms = measure_ms([&]() {
+        for (size_t i = 0; i < n; ++i) {
+            sorter.push_back((int)(((unsigned)rand() << 15) ^ (unsigned)rand()));
+        }
+    });
+    size_t runs = sorter.runs();
+    string output_path = VectorLegacyExternalSort<int>::default_temp_dir() + "/vectorlegacy-external-bench.bin";
+    VectorLegacyFile<int> output;
+    double merge_ms = measure_ms([&]() { output = sorter.finish(output_path); });
+    cout << "  runs: " << runs << ", fill and spill " << spill_ms << " ms, merge " << merge_ms << " ms" << endl;
+    std::remove(output_path.c_str());
+}
+
+//Создание и копирование рабочего буфера из n чисел: поэлементный цикл против VectorLegacy
+void benchmark_fill(size_t n) {
+    cout << "fill and copy, " << n << " ints (" << n * sizeof(int) / (1024 * 1024) << " MB)" << endl;
+    double loop_fill_ms = measure_ms([&]() {
+        int* data = new int[n];
+        for (size_t i = 0; i < n; ++i) {
+            data[i] = 7;
+        }
+        int* copy = new int[n];
+        for (size_t i = 0; i < n; ++i) {
+            copy[i] = data[i];
+        }
+        volatile int sink = copy[n - 1] + data[n / 2];
+        (void)sink;
+        delete[] copy;
+        delete[] data;
+    });
+    double zero_ms = 0, fill_ms = 0, copy_ms = 0;
+    {
+        zero_ms = measure_ms([&]() { VectorLegacy<int> zeros(n, 0); });
+        VectorLegacy<int> filled;
+        fill_ms = measure_ms([&]() { filled = VectorLegacy<int>(n, 7); });
+        copy_ms = measure_ms([&]() { VectorLegacy<int> cloned(filled); });
+    }
+    cout << "  loop fill + copy " << loop_fill_ms << " ms; VectorLegacy: zero fill " << zero_ms
+        << " ms, fill " << fill_ms << " ms, copy " << copy_ms << " ms" << endl;
+}
+
+//Слияние shards отсортированных частей по n чисел: склейка и сортировка против k-путевого слияния.
+//Во втором наборе значения частей лишь немного заходят на соседние (например, части по времени) --
+//длинные серии одной части слияние переносит галопом
+void benchmark_merge(size_t shards, size_t n) {
+    cout << "merge, " << shards << " sorted shards of " << n << " ints" << endl;
+    srand(42);
+    for (int ranged = 0; ranged < 2; ++ranged) {
+        VectorLegacy<VectorLegacy<int>> parts;
+        for (size_t s = 0; s < shards; ++s) {
+            VectorLegacy<int> part;
+            for (size_t i = 0; i < n; ++i) {
+                int value = (int)(((unsigned)rand() << 15) ^ (unsigned)rand());
+                part.push_back(ranged ? (int)(s * (1 << 20)) + value % ((1 << 20) + (1 << 17)) : value);
+            }
+            part.sort();
+            parts.push_back(part);
+        }
+        VectorLegacy<int> resorted;
+        double resort_ms = measure_ms([&]() {
+            resorted = VectorLegacy<int>();
+            for (size_t s = 0; s < shards; ++s) {
+                resorted.append(parts[s]);
+            }
+            resorted.sort();
+        });
+        VectorLegacy<int> merged;
+        double merge_ms = measure_ms([&]() { merged = VectorLegacy<int>::merge_sorted(parts); });
+        double parallel_ms = measure_ms([&]() { merged = VectorLegacy<int>::parallel_merge_sorted(parts); });
+        cout << (ranged ? "  neighbour ranges" : "  random") << ": append + sort " << resort_ms << " ms, merge_sorted "
+            << merge_ms << " ms, parallel " << parallel_ms << " ms" << (merged == resorted ? "" : " MISMATCH") << endl;
+    }
+}
+
+//Проход, случайное чтение и сортировка n чисел на обычных и на больших страницах.
+//Случайное чтение по большому массиву почти всегда промахивается мимо TLB, большие страницы
+//сокращают и число промахов, и стоимость обхода таблицы страниц
+void benchmark_huge_pages(size_t n) {
+    cout << "huge pages, " << n << " ints (" << n * sizeof(int) / (1024 * 1024) << " MB)" << endl;
+    size_t probes = 20000000;
+    for (int huge = 0; huge < 2; ++huge) {
+        VectorLegacy<int> values;
+        if (huge) {
+            values.enable_huge_pages();
+        }
+        srand(42);
+        double fill_ms = measure_ms([&]() {
+            for (size_t i = 0; i < n; ++i) {
+                values.push_back((int)(((unsigned)rand() << 15) ^ (unsigned)rand()));
+            }
+        });
+        size_t huge_mb = huge_pages_mb();
+        long long sum = 0;
+        double scan_ms = measure_ms([&]() {
+            for (const int* p = values.begin(); p != values.end(); ++p) {
+                sum += *p;
+            }
+        });
+        const int* data = values.begin();
+        size_t position = 12345;
+        double random_ms = measure_ms([&]() {
+            for (size_t i = 0; i < probes; ++i) {
+                position = (position * 6364136223846793005ULL + 1442695040888963407ULL) >> 7;
+                sum += data[position % n];
+            }
+        });
+        double sort_ms = measure_ms([&]() { values.sort(); });
+        cout << (huge ? "  huge pages" : "  4K pages") << " (" << huge_mb << " MB on huge pages): fill " << fill_ms
+            << " ms, scan " << n * sizeof(int) / (scan_ms * 1000) << " MB/s, random read "
+            << random_ms * 1000000 / probes << " ns, sort " << sort_ms << " ms (" << sum % 10 << ")" << endl;
+    }
+}
+
+//Удаление около 30% из n случайных чисел: remove_if, erase_indices и erase_value за один проход.
+//Для сравнения -- delete_ в цикле, каждый вызов сдвигает хвост (на меньшем массиве: работа О(n k))
+void benchmark_prune(size_t n) {
+    cout << "prune, " << n << " ints, about 30% removed" << endl;
+    srand(42);
+    VectorLegacy<int> source;
+    VectorLegacy<size_t> doomed;
+    for (size_t i = 0; i < n; ++i) {
+        source.push_back(rand() % 10);
+        if (source[i] < 3) {
+            doomed.push_back(i);
+        }
+    }
+    VectorLegacy<int> values(source);
+    double remove_if_ms = measure_ms([&]() { values.remove_if([](int x) { return x < 3; }); });
+    size_t kept = values.size();
+    values = source;
+    double indices_ms = measure_ms([&]() { values.erase_indices(doomed); });
+    bool same = values.size() == kept;
+    values = source;
+    double value_ms = measure_ms([&]() {
+        for (int x = 0; x < 3; ++x) {
+            values.erase_value(x);
+        }
+    });
+    same = same && values.size() == kept;
+
+    size_t small = min(n, (size_t)200000);
+    VectorLegacy<int> looped(source.begin(), source.begin() + small);
+    double loop_ms = measure_ms([&]() {
+        for (size_t i = looped.size(); i-- > 0;) {
+            if (looped[i] < 3) {
+                looped.delete_(i);
+            }
+        }
+    });
+    cout << "  remove_if " << remove_if_ms << " ms, erase_indices " << indices_ms << " ms, erase_value x3 "
+        << value_ms << " ms" << (same ? "" : " MISMATCH") << "; delete_ loop on " << small << " ints " << loop_ms << " ms" << endl;
+}
+
+//Память и время поиска: отсортированный массив n идентификаторов с малыми разрывами против сжатого
+void benchmark_compressed(size_t n) {
+    cout << "compressed, " << n << " sorted ints" << endl;
+    VectorLegacy<int> ids;
+    srand(42);
+    int id = 0;
+    for (size_t i = 0; i < n; ++i) {
+        id += 1 + rand() % 16;
+        ids.push_back(id);
+    }
+    ids.sort();
+
+    VectorLegacyCompressed<int> packed;
+    double compress_ms = measure_ms([&]() { packed = ids.compress(); });
+    cout << "  memory: plain " << ids.size() * sizeof(int) / 1024 << " KB, compressed "
+        << packed.memory() / 1024 << " KB (compress " << compress_ms << " ms)" << endl;
+
+    const size_t lookups = 1000000;
+    VectorLegacy<int> queries;
+    for (size_t i = 0; i < lookups; ++i) {
+        queries.push_back(1 + (int)(((unsigned)rand() << 15 ^ (unsigned)rand()) % (unsigned)id));
+    }
+    size_t found_plain = 0;
+    size_t found_packed = 0;
+    double plain_ms = measure_ms([&]() {
+        for (size_t i = 0; i < lookups; ++i) {
+            found_plain += ids.seek(queries[i]) != ids.size();
+        }
+    });
+    double packed_ms = measure_ms([&]() {
+        for (size_t i = 0; i < lookups; ++i) {
+            found_packed += packed.seek(queries[i]) != packed.size();
+        }
+    });
+    cout << "  seek: plain " << plain_ms * 1000000 / lookups << " ns, compressed "
+        << packed_ms * 1000000 / lookups << " ns (found " << found_plain << " / " << found_packed << ")" << endl;
+}
+
+//Процедура замеров производительности
+void benchmark() {
+    benchmark_growth(96 * 1024 * 1024);
+    benchmark_selection(10000000);
+    benchmark_presorted(10000000);
+    benchmark_latency(4000000);
+    benchmark_index(1000000, 10000);
+    benchmark_external(50000000, 32);
+    benchmark_compressed(50000000);
+    benchmark_fill(256 * 1024 * 1024);
+    benchmark_merge(64, 250000);
+    benchmark_huge_pages(512 * 1024 * 1024);
+    benchmark_prune(20000000);
+}
@@ -2,10 +2,30 @@
 #include <algorithm>
 #include <sstream>
 #include <iostream>
+#include <iterator>
 #include <list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 #include <stdlib.h>
+#include <cstring>
+#include <cstdint>
 #include <cassert>
+#include <atomic>
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define VECTORLEGACY_SSSE3
+#endif
+#include "ThreadPool.h"
+#include "VectorLegacyKernels.h"
+#include "VectorLegacyView.h"
+#include "VectorLegacyIndex.h"
 /*
 Memcpy vs. copy_n:
 Memcpy:
@@ -53,6 +73,15 @@ size_t n: Количество __элементов__, которые нужно
 4 параметр -- конец источника
 */
 using namespace std;
+template <typename... Fields>
+class VectorLegacySoA;
+template <typename T>
+class VectorLegacyCompressed;
+template <typename T>
+class VectorLegacyFile;
+template <typename T, typename Compare>
+class VectorLegacyExternalSort;
+
 template <typename T>
 class VectorLegacy {
 private:
@@ -64,6 +93,41 @@ private:
     T* m_data;
     // Сортирован ли массив?
     bool m_sorted;
+    // Счетчик владельцев буфера в режиме копирования при записи (enable_cow), иначе nullptr.
+    // Копии такого массива разделяют буфер, а первое изменение делает собственную копию
+    atomic<size_t>* m_refs;
+    // Незавершенный перенос в новый буфер при постепенном росте (enable_incremental_growth).
+    // Элементы [moved, count) еще лежат в старом буфере old, остальные -- уже в m_data
+    struct Migration {
+        T* old;
+        size_t old_capacity;
+        size_t count;
+        size_t moved;
+        // Сколько элементов переносит одна операция
+        size_t step;
+    };
+    Migration* m_migration;
+    // Сколько элементов переносить за одну операцию при росте, 0 -- переносить сразу все
+    size_t m_growth_step;
+    // Хеш-индекс значение -> первая позиция (enable_index), иначе nullptr
+    VectorLegacyIndex<T>* m_index;
+    // Выравнивание буфера в байтах (set_alignment), 0 -- обычный new T[]
+    size_t m_alignment;
+    // Большие страницы для отображенных буферов (enable_huge_pages)
+    bool m_huge_pages;
+    // Массивы других типов (ключи сортировки и т.п.) работают с буфером напрямую
+    template <typename U>
+    friend class VectorLegacy;
+    // Колонки хранилища структур по полям переставляются и растут напрямую
+    template <typename... Fields>
+    friend class VectorLegacySoA;
+    template <typename U>
+    friend class VectorLegacyCompressed;
+    // Внешняя сортировка и файловый массив заполняют буферы серий и чтения напрямую
+    template <typename U>
+    friend class VectorLegacyFile;
+    template <typename U, typename Compare>
+    friend class VectorLegacyExternalSort;
     /*
     Используем функцию GlobalMemoryStatusEx из Windows API для получения информации о памяти.
     Проверяем, не возникла ли ошибка при получении информации о памяти.
@@ -71,6 +135,7 @@ private:
     */
     //Метод для получения размера свободной памяти
     static size_t GetFreeMemory() {
+#ifdef _WIN32
         MEMORYSTATUSEX ms;
         ms.dwLength = sizeof(ms);
 
@@ -79,18 +144,385 @@ private:
         }
 
         return ms.ullAvailPhys; // Возвращает количество свободной памяти в указанном типе данных
+#else
+        long pages = sysconf(_SC_AVPHYS_PAGES);
+        long page_size = sysconf(_SC_PAGESIZE);
+        if (pages < 0 || page_size < 0) {
+            return 0; // Ошибка при получении информации о памяти
+        }
+        return (size_t)pages * (size_t)page_size;
+#endif
+    }
+
+    /*
+    Режим больших буферов (только Linux).
+    Буферы тривиально копируемых типов размером от map_threshold() байт берутся напрямую у ядра через mmap,
+    а растут через mremap(MREMAP_MAYMOVE): ядро переносит страницы, не копируя данные,
+    поэтому пиковое потребление памяти при росте остается около 1x вместо 2x.
+    Способ выделения однозначно определяется вместимостью и режимом размещения (m_alignment, m_huge_pages),
+    поэтому отдельный флаг не хранится. Режим меняется только вместе с буфером (relayout),
+    а копии в режиме копирования при записи разделяют буфер только с одинаковым режимом.
+    */
+    static size_t map_threshold() {
+        return 4 * 1024 * 1024;
+    }
+
+    // Размер большой страницы
+    static size_t huge_page_size() {
+        return 2 * 1024 * 1024;
+    }
+
+    // Можно ли буфер на n элементов отдать под mmap
+    static bool use_map(size_t n) {
+#ifdef __linux__
+        return is_trivially_copyable<T>::value && is_trivially_default_constructible<T>::value
+            && n != 0 && n >= map_threshold() / sizeof(T);
+#else
+        (void)n;
+        return false;
+#endif
+    }
+
+#ifdef __linux__
+    // Размер отображения в байтах, выровненный по странице (в режиме больших страниц -- по большой странице)
+    static size_t map_bytes(size_t n, bool huge) {
+        size_t page = huge ? huge_page_size() : (size_t)sysconf(_SC_PAGESIZE);
+        return (n * sizeof(T) + page - 1) / page * page;
+    }
+
+    // Выравнивание отображения: mmap дает только границу обычной страницы
+    static size_t map_alignment(size_t alignment, bool huge) {
+        return huge ? max(alignment, huge_page_size()) : alignment;
+    }
+
+    // Анонимное отображение bytes байт с началом, кратным alignment. Если alignment больше страницы,
+    // отображается с запасом, а лишние голова и хвост возвращаются ядру.
+    // Если target не nullptr, буфер target размером old_bytes переносится в новое место без копирования
+    static void* map_aligned(size_t bytes, size_t alignment, void* target = nullptr, size_t old_bytes = 0) {
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        if (alignment <= page && target != nullptr) {
+            void* p = mremap(target, old_bytes, bytes, MREMAP_MAYMOVE);
+            if (p == MAP_FAILED) {
+                throw bad_alloc();
+            }
+            return p;
+        }
+        size_t extra = alignment > page ? alignment - page : 0;
+        void* p = mmap(nullptr, bytes + extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            throw bad_alloc();
+        }
+        char* first = static_cast<char*>(p);
+        if (extra != 0) {
+            size_t head = (alignment - reinterpret_cast<uintptr_t>(first) % alignment) % alignment;
+            if (head != 0) {
+                munmap(first, head);
+            }
+            if (extra != head) {
+                munmap(first + head + bytes, extra - head);
+            }
+            first += head;
+        }
+        // Место зарезервировано -- страницы старого буфера переносятся поверх него
+        if (target != nullptr) {
+            void* moved = mremap(target, old_bytes, bytes, MREMAP_MAYMOVE | MREMAP_FIXED, first);
+            if (moved == MAP_FAILED) {
+                munmap(first, bytes);
+                throw bad_alloc();
+            }
+        }
+        return first;
+    }
+
+    // Просьба к ядру отдать отображение большими страницами. Ядро без их поддержки просьбу отклоняет,
+    // тогда буфер просто остается на обычных страницах
+    static void advise_huge(void* data, size_t bytes, bool huge) {
+#ifdef MADV_HUGEPAGE
+        if (huge) {
+            madvise(data, bytes, MADV_HUGEPAGE);
+        }
+#else
+        (void)data;
+        (void)bytes;
+        (void)huge;
+#endif
+    }
+#endif
+
+    // Выравненный буфер из кучи: память выделяется отдельно, элементы создаются на месте
+    static T* allocate_aligned(size_t n, size_t alignment) {
+        size_t bytes = max(n, (size_t)1) * sizeof(T);
+        alignment = max(alignment, alignof(T));
+#ifdef _WIN32
+        void* p = _aligned_malloc(bytes, alignment);
+#else
+        void* p = nullptr;
+        if (posix_memalign(&p, alignment, bytes) != 0) {
+            p = nullptr;
+        }
+#endif
+        if (p == nullptr) {
+            throw bad_alloc();
+        }
+        T* data = static_cast<T*>(p);
+        size_t built = 0;
+        try {
+            for (; built < n; ++built) {
+                new (data + built) T;
+            }
+        }
+        catch (...) {
+            destroy_aligned(data, built);
+            throw;
+        }
+        return data;
     }
 
+    // Разрушение count элементов и освобождение буфера allocate_aligned
+    static void destroy_aligned(T* data, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            data[i].~T();
+        }
+#ifdef _WIN32
+        _aligned_free(data);
+#else
+        free(data);
+#endif
+    }
+
+    // Выделение буфера на n элементов в режиме размещения alignment, huge
+    static T* allocate(size_t n, size_t alignment, bool huge) {
+#ifdef __linux__
+        if (use_map(n)) {
+            void* p = map_aligned(map_bytes(n, huge), map_alignment(alignment, huge));
+            advise_huge(p, map_bytes(n, huge), huge);
+            return static_cast<T*>(p);
+        }
+#else
+        (void)huge;
+#endif
+        if (alignment != 0) {
+            return allocate_aligned(n, alignment);
+        }
+        return new T[n];
+    }
+
+    // Освобождение буфера, выделенного allocate(n, alignment, huge)
+    static void deallocate(T* data, size_t n, size_t alignment, bool huge) {
+        if (data == nullptr) {
+            return;
+        }
+#ifdef __linux__
+        if (use_map(n)) {
+            munmap(data, map_bytes(n, huge));
+            return;
+        }
+#else
+        (void)huge;
+#endif
+        if (alignment != 0) {
+            destroy_aligned(data, n);
+            return;
+        }
+        delete[] data;
+    }
+
+    // Выделение буфера на n элементов в текущем режиме размещения
+    T* allocate(size_t n) const {
+        return allocate(n, m_alignment, m_huge_pages);
+    }
+
+    // Освобождение буфера, выделенного allocate(n)
+    void deallocate(T* data, size_t n) const {
+        deallocate(data, n, m_alignment, m_huge_pages);
+    }
+
+    // Перенос элементов в буфер с новым режимом размещения. Позиции не меняются, индекс остается актуальным
+    void relayout(size_t alignment, bool huge) {
+        settle();
+        if (alignment == m_alignment && huge == m_huge_pages) {
+            return;
+        }
+        if (m_data == nullptr) {
+            m_alignment = alignment;
+            m_huge_pages = huge;
+            return;
+        }
+        T* new_data = allocate(m_capacity, alignment, huge);
+        relocate(new_data);
+        bool cow = m_refs != nullptr;
+        release();
+        m_data = new_data;
+        m_refs = cow ? new atomic<size_t>(1) : nullptr;
+        m_alignment = alignment;
+        m_huge_pages = huge;
+    }
+
+    // Разделен ли буфер с другими копиями
+    bool shared() const {
+        return m_refs != nullptr && m_refs->load(memory_order_acquire) > 1;
+    }
+
+    // Отказ от текущего буфера. Буфер освобождается, только если им больше никто не владеет.
+    // После вызова m_data и m_refs недействительны
+    void release() {
+        if (m_migration != nullptr) {
+            deallocate(m_migration->old, m_migration->old_capacity);
+            delete m_migration;
+            m_migration = nullptr;
+        }
+        if (m_refs != nullptr && m_refs->fetch_sub(1, memory_order_acq_rel) != 1) {
+            return;
+        }
+        deallocate(m_data, m_capacity);
+        delete m_refs;
+    }
+
+    // Замена буфера на собственный new_data. Режим копирования при записи сохраняется
+    void replace_buffer(T* new_data, size_t new_capacity) {
+        if (m_index != nullptr) {
+            m_index->invalidate();
+        }
+        bool cow = m_refs != nullptr;
+        release();
+        m_data = new_data;
+        m_capacity = new_capacity;
+        m_refs = cow ? new atomic<size_t>(1) : nullptr;
+    }
+
+    // Перенос до count элементов из старого буфера. Когда перенесено все, старый буфер освобождается
+    void migrate(size_t count) {
+        Migration* m = m_migration;
+        size_t stop = m->moved + min(count, m->count - m->moved);
+        std::move(m->old + m->moved, m->old + stop, m_data + m->moved);
+        m->moved = stop;
+        if (m->moved == m->count) {
+            deallocate(m->old, m->old_capacity);
+            delete m;
+            m_migration = nullptr;
+        }
+    }
+
+    // Завершение переноса целиком. Нужно всем изменяющим операциям, которые работают с буфером подряд.
+    // Константные операции перенос не продвигают и читают через element() или for_runs()
+    void settle() {
+        if (m_migration != nullptr) {
+            migrate(m_migration->count);
+        }
+    }
+
+    // Шаг переноса для операций с ограниченной работой (push_back, pop_back, [], at, back).
+    // Без переноса -- unshare. Индекс не трогает: push_back и pop_back обновляют его сами,
+    // а [], at и back помечают устаревшим
+    void step() {
+        if (m_migration != nullptr) {
+            migrate(m_migration->step);
+        }
+        else {
+            unshare();
+        }
+    }
+
+    // Элемент index с учетом незавершенного переноса
+    T& element(size_t index) const {
+        if (m_migration != nullptr && index >= m_migration->moved && index < m_migration->count) {
+            return m_migration->old[index];
+        }
+        return m_data[index];
+    }
+
+    // Вызывает body(p, n) для кусков [lo, hi), лежащих подряд в одном буфере. Во время переноса
+    // [moved, count) еще в старом буфере, остальное -- в новом
+    template <typename F>
+    void for_runs(size_t lo, size_t hi, F body) const {
+        while (lo < hi) {
+            const T* p = m_data;
+            size_t stop = hi;
+            if (m_migration != nullptr) {
+                if (lo < m_migration->moved) {
+                    stop = min(hi, m_migration->moved);
+                }
+                else if (lo < m_migration->count) {
+                    stop = min(hi, m_migration->count);
+                    p = m_migration->old;
+                }
+            }
+            body(p + lo, stop - lo);
+            lo = stop;
+        }
+    }
+
+    // Копирование элементов в dst (место под m_size элементов)
+    void copy_to(T* dst) const {
+        for_runs(0, m_size, [&](const T* p, size_t n) {
+            copy_buffer(dst, p, n);
+            dst += n;
+        });
+    }
+
+    // Элементы подряд для константных операций, которым нужен указатель. Во время переноса
+    // элементы собираются в scratch, сам массив не меняется
+    const T* contiguous(VectorLegacy& scratch) const {
+        if (m_migration == nullptr) {
+            return m_data;
+        }
+        scratch = *this;
+        return scratch.m_data;
+    }
+
+    // Актуален ли индекс. Операции, обновляющие индекс на месте, проверяют это до изменения
+    bool index_fresh() const {
+        return m_index != nullptr && m_index->fresh();
+    }
+
+    // Вызывается перед любым изменением элементов: разделенный буфер копируется, индекс устаревает
+    void detach() {
+        if (m_index != nullptr) {
+            m_index->invalidate();
+        }
+        unshare();
+    }
+
+    // Собственная копия разделенного буфера (режим копирования при записи) без пометки индекса
+    void unshare() {
+        settle();
+        if (shared()) {
+            T* new_data = allocate(m_capacity);
+            copy_buffer(new_data, m_data, m_size);
+            replace_buffer(new_data, m_capacity);
+        }
+    }
 
     // Функция для увеличения вместимости массива
     void resize(size_t new_capacity) {
-        T* new_data = new T[new_capacity];
+        settle();
+#ifdef __linux__
+        //Оба буфера отображены -- переносим страницы без копирования. Выравнивание сохраняется:
+        //при выравнивании больше страницы место под буфер резервируется заранее
+        if (m_data != nullptr && !shared() && use_map(m_capacity) && use_map(new_capacity)) {
+            size_t bytes = map_bytes(new_capacity, m_huge_pages);
+            void* p = map_aligned(bytes, map_alignment(m_alignment, m_huge_pages), m_data, map_bytes(m_capacity, m_huge_pages));
+            advise_huge(p, bytes, m_huge_pages);
+            m_data = static_cast<T*>(p);
+            m_capacity = new_capacity;
+            return;
+        }
+#endif
+        //Постепенный рост: новый буфер выделяется сразу, а элементы переносятся по частям
+        //следующими операциями. Шаг не меньше такого, чтобы перенос закончился до следующего роста
+        if (m_growth_step != 0 && m_refs == nullptr && m_size > m_growth_step && new_capacity > m_size) {
+            size_t room = new_capacity - m_size;
+            T* new_data = allocate(new_capacity);
+            m_migration = new Migration{ m_data, m_capacity, m_size, 0, max(m_growth_step, (m_size + room - 1) / room) };
+            m_data = new_data;
+            m_capacity = new_capacity;
+            return;
+        }
+        T* new_data = allocate(new_capacity);
         //memcpy(new_data, m_data, m_size * sizeof(T));
         //copy_n(m_data, m_size, new_data);
-        copy(begin(), end(), new_data);
-        delete[] m_data;
-        m_data = new_data;
-        m_capacity = new_capacity;
+        relocate(new_data);
+        replace_buffer(new_data, new_capacity);
     }
 
 
@@ -115,14 +547,8 @@ private:
             new_capacity = m_capacity + 1024;
         }
 
-        T* new_data = new T[new_capacity];
         //Перенос информации
-        //copy_n(m_data, m_size, new_data);
-        copy(begin(), end(), new_data);
-        //memcpy(new_data, m_data, m_size * sizeof(T));
-        delete[] m_data;
-        m_data = new_data;
-        m_capacity = new_capacity;
+        resize(new_capacity);
     }
 
 
@@ -134,8 +560,8 @@ private:
             throw(out_of_range("Not enough capacity to shift"));
         }
     //Не использую memcpy или copy_n во избежание наложения данных друг на друга
-        for (size_t i = m_size - 1; i >= index + count; --i) {
-            m_data[i + count] = m_data[i];
+        for (size_t i = m_size; i > index; --i) {
+            m_data[i + count - 1] = m_data[i - 1];
         }
     }
 
@@ -151,36 +577,538 @@ private:
         }
     }
 
-    size_t partition(size_t low, size_t high) {
-        // Выбор опорного элемента
-        size_t pivot_index = low + rand() % (high - low + 1);
+    //Разбиение Ломуто. comp -- строгий порядок "меньше", по умолчанию operator<
+    template <typename Compare = less<T>>
+    size_t partition(size_t low, size_t high, Compare comp = Compare()) {
+        return VectorLegacyKernels::partition(m_data, low, high, comp);
+    }
+
+
+    // Упорядочивает ли comp массив по возрастанию в смысле m_sorted
+    template <typename Compare>
+    static bool ascending(Compare) {
+        return is_same<Compare, less<T>>::value;
+    }
+
+    // Сортировка с компаратором: адаптивная по сериям (sort_runs).
+    // m_sorted не проверяется: запись через [], at и back его не сбрасывает, а уже отсортированный
+    // массив -- одна серия, n - 1 сравнение
+    template <typename Compare>
+    void sort_with(Compare comp) {
+        if (m_size < 2) {
+            return;
+        }
+        detach();
+        sort_runs(comp);
+    }
+
+    // Перестановка элементов по циклам: на место i встает элемент order[i].second.
+    // order портится: обработанные позиции помечаются как неподвижные
+    template <typename Pair>
+    void permute(VectorLegacy<Pair>& order) {
+        for (size_t i = 0; i < m_size; ++i) {
+            if (order.m_data[i].second == i) {
+                continue;
+            }
+            T value = std::move(m_data[i]);
+            size_t j = i;
+            while (order.m_data[j].second != i) {
+                size_t from = order.m_data[j].second;
+                m_data[j] = std::move(m_data[from]);
+                order.m_data[j].second = j;
+                j = from;
+            }
+            m_data[j] = std::move(value);
+            order.m_data[j].second = j;
+        }
+    }
+
+    // Первая позиция в [first, first + n), где элемент не меньше value (before(элемент, value) ложно).
+    // Экспоненциальный поиск: О(log(d)), где d -- ответ, поэтому короткие прыжки стоят дешево
+    template <typename Before = less<T>>
+    static size_t gallop(const T* first, size_t n, const T& value, Before before = Before()) {
+        size_t bound = 1;
+        while (bound < n && before(first[bound - 1], value)) {
+            bound *= 2;
+        }
+        return (size_t)(lower_bound(first + bound / 2, first + min(bound, n), value, before) - first);
+    }
+
+    // Длина естественной серии, начинающейся с lo. Строго убывающая серия разворачивается
+    // (строгость нужна для устойчивости: равные элементы не меняются местами)
+    template <typename Compare>
+    size_t find_run(size_t lo, Compare comp) {
+        size_t hi = lo + 1;
+        if (hi == m_size) {
+            return 1;
+        }
+        if (comp(m_data[hi], m_data[lo])) {
+            while (hi + 1 < m_size && comp(m_data[hi + 1], m_data[hi])) {
+                ++hi;
+            }
+            std::reverse(m_data + lo, m_data + hi + 1);
+        }
+        else {
+            while (hi + 1 < m_size && !comp(m_data[hi + 1], m_data[hi])) {
+                ++hi;
+            }
+        }
+        return hi + 1 - lo;
+    }
+
+    // Приоритет границы между сериями [s1, s1 + n1) и [s1 + n1, s1 + n1 + n2) в powersort:
+    // номер первого различающегося бита середин серий, деленных на n. Чем больше, тем глубже
+    // граница в дереве слияний и тем раньше ее надо сливать
+    static unsigned run_power(size_t s1, size_t n1, size_t n2, size_t n) {
+        unsigned result = 0;
+        size_t a = 2 * s1 + n1;
+        size_t b = a + n1 + n2;
+        for (;;) {
+            ++result;
+            if (a >= n) {
+                a -= n;
+                b -= n;
+            }
+            else if (b >= n) {
+                break;
+            }
+            a <<= 1;
+            b <<= 1;
+        }
+        return result;
+    }
+
+    // Устойчивое слияние соседних серий [lo, mid) и [mid, hi). Левая серия переносится в buffer.
+    // Начало левой и конец правой, которые уже на месте, отсекаются галопом. Если одна серия
+    // выигрывает MIN_GALLOP сравнений подряд, слияние переходит на прыжки галопом
+    template <typename Compare>
+    void merge_runs(size_t lo, size_t mid, size_t hi, VectorLegacy& buffer, Compare comp) {
+        const size_t MIN_GALLOP = 7;
+        auto not_after = [&comp](const T& a, const T& b) { return !comp(b, a); };
+        lo += gallop(m_data + lo, mid - lo, m_data[mid], not_after);
+        if (lo == mid) {
+            return;
+        }
+        hi = mid + gallop(m_data + mid, hi - mid, m_data[mid - 1], comp);
+
+        size_t n1 = mid - lo;
+        if (buffer.m_capacity < n1) {
+            buffer.m_size = 0;
+            buffer.reserve_for(n1);
+        }
+        T* left = buffer.m_data;
+        std::move(m_data + lo, m_data + mid, left);
+
+        size_t i = 0, j = mid, k = lo;
+        size_t left_wins = 0, right_wins = 0;
+        while (i < n1 && j < hi) {
+            if (comp(m_data[j], left[i])) {
+                m_data[k++] = std::move(m_data[j++]);
+                ++right_wins;
+                left_wins = 0;
+            }
+            else {
+                m_data[k++] = std::move(left[i++]);
+                ++left_wins;
+                right_wins = 0;
+            }
+            if (left_wins < MIN_GALLOP && right_wins < MIN_GALLOP) {
+                continue;
+            }
+            // Галоп, пока прыжки длинные
+            size_t jumped;
+            do {
+                jumped = 0;
+                if (i < n1 && j < hi) {
+                    size_t count = gallop(m_data + j, hi - j, left[i], comp);
+                    std::move(m_data + j, m_data + j + count, m_data + k);
+                    j += count;
+                    k += count;
+                    jumped = count;
+                }
+                if (i < n1 && j < hi) {
+                    size_t count = gallop(left + i, n1 - i, m_data[j], not_after);
+                    std::move(left + i, left + i + count, m_data + k);
+                    i += count;
+                    k += count;
+                    jumped = max(jumped, count);
+                }
+            } while (jumped >= MIN_GALLOP);
+            left_wins = right_wins = 0;
+        }
+        // Остаток правой серии уже на месте
+        std::move(left + i, left + n1, m_data + k);
+    }
+
+    //Средний: О(n log(n)), Лучший: О(n) для почти отсортированного массива
+    //Адаптивная устойчивая сортировка (powersort): массив разбивается на естественные серии,
+    //короткие серии доращиваются вставками до MIN_RUN, серии сливаются в порядке, который
+    //задают приоритеты границ. Для k серий работа О(n log(k))
+    template <typename Compare>
+    void sort_runs(Compare comp) {
+        const size_t MIN_RUN = 32;
+        struct Run {
+            size_t start;
+            size_t length;
+            unsigned power;
+        };
+        // Приоритеты на стеке строго возрастают, поэтому глубина не больше разрядности size_t
+        Run stack[8 * sizeof(size_t) + 1];
+        size_t top = 0;
+        VectorLegacy buffer;
+
+        auto next_run = [&](size_t lo) {
+            size_t length = find_run(lo, comp);
+            if (length < MIN_RUN) {
+                size_t forced = min(MIN_RUN, m_size - lo);
+                sort_insertion(lo, lo + forced, comp);
+                length = forced;
+            }
+            return length;
+        };
+
+        size_t lo = 0;
+        size_t length = next_run(0);
+        while (lo + length < m_size) {
+            size_t next = lo + length;
+            size_t next_length = next_run(next);
+            unsigned power = run_power(lo, length, next_length, m_size);
+            while (top > 0 && stack[top - 1].power > power) {
+                --top;
+                merge_runs(stack[top].start, lo, lo + length, buffer, comp);
+                length += lo - stack[top].start;
+                lo = stack[top].start;
+            }
+            stack[top++] = { lo, length, power };
+            lo = next;
+            length = next_length;
+        }
+        while (top > 0) {
+            --top;
+            merge_runs(stack[top].start, lo, lo + length, buffer, comp);
+            length += lo - stack[top].start;
+            lo = stack[top].start;
+        }
+    }
+
+    // Слияние двух отсортированных массивов с выбором, какие элементы попадают в результат:
+    // только из this, общие, только из other. Кратности как у std::set_union и др.
+    // Неотсортированные входы сортируются в копиях. При сильно разных размерах серии
+    // меньших элементов пропускаются галопом, а не по одному
+    VectorLegacy set_sweep(const VectorLegacy& other, bool keep_this, bool keep_common, bool keep_other) const {
+        VectorLegacy sorted_this;
+        VectorLegacy sorted_other;
+        const VectorLegacy* a = this;
+        const VectorLegacy* b = &other;
+        // Во время переноса элементы не лежат подряд -- работаем с собранной копией
+        if (!m_sorted || m_migration != nullptr) {
+            sorted_this = *this;
+            if (!m_sorted) {
+                sorted_this.sort();
+            }
+            a = &sorted_this;
+        }
+        if (!other.m_sorted || other.m_migration != nullptr) {
+            sorted_other = other;
+            if (!other.m_sorted) {
+                sorted_other.sort();
+            }
+            b = &sorted_other;
+        }
+
+        const T* pa = a->m_data;
+        const T* pb = b->m_data;
+        size_t na = a->m_size;
+        size_t nb = b->m_size;
+        bool galloping = max(na, nb) / 8 > min(na, nb);
+
+        VectorLegacy result;
+        result.reserve_for(keep_this && keep_other ? na + nb : keep_this ? na : min(na, nb));
+        auto emit = [&result](const T* from, const T* to) {
+            copy(from, to, result.m_data + result.m_size);
+            result.m_size += (size_t)(to - from);
+        };
+
+        size_t i = 0, j = 0;
+        while (i < na && j < nb) {
+            if (pa[i] < pb[j]) {
+                size_t k = galloping ? i + gallop(pa + i, na - i, pb[j]) : i + 1;
+                if (keep_this) {
+                    emit(pa + i, pa + k);
+                }
+                i = k;
+            }
+            else if (pb[j] < pa[i]) {
+                size_t k = galloping ? j + gallop(pb + j, nb - j, pa[i]) : j + 1;
+                if (keep_other) {
+                    emit(pb + j, pb + k);
+                }
+                j = k;
+            }
+            else {
+                if (keep_common) {
+                    emit(pa + i, pa + i + 1);
+                }
+                ++i;
+                ++j;
+            }
+        }
+        if (keep_this) {
+            emit(pa + i, pa + na);
+        }
+        if (keep_other) {
+            emit(pb + j, pb + nb);
+        }
+        result.m_sorted = true;
+        return result;
+    }
 
-        T pivot = m_data[pivot_index];
-        std::swap(m_data[pivot_index], m_data[high]);
+    // Слияние k отсортированных диапазонов [first[i], last[i]) в out турниром с деревом проигравших.
+    // Устойчиво: при равенстве побеждает диапазон с меньшим номером. Закончившийся диапазон убирается,
+    // и дерево строится заново, поэтому в самом турнире проверок на конец нет.
+    // Если один диапазон выигрывает MIN_GALLOP раз подряд, его серия, идущая до головы второго
+    // по порядку диапазона, находится галопом и копируется целиком
+    template <typename Compare>
+    static void merge_k(const T* const* first, const T* const* last, size_t k, T* out, Compare comp) {
+        const size_t MIN_GALLOP = 7;
+        typename is_trivially_copyable<T>::type trivial;
+        // Непустые диапазоны в исходном порядке: номер листа упорядочен так же, как номер входа
+        VectorLegacy<const T*> ranges;
+        ranges.reserve_for(2 * k);
+        const T** head = ranges.m_data;
+        const T** end = ranges.m_data + k;
+        size_t m = 0;
+        for (size_t i = 0; i < k; ++i) {
+            if (first[i] != last[i]) {
+                head[m] = first[i];
+                end[m++] = last[i];
+            }
+        }
+        // Побеждает ли лист a лист b: при равенстве -- меньший номер
+        auto beats = [&](size_t a, size_t b) {
+            const T& x = *head[a];
+            const T& y = *head[b];
+            return comp(x, y) | (!comp(y, x) & (a < b));
+        };
+
+        VectorLegacy<size_t> nodes;
+        nodes.reserve_for(3 * k);
+        while (m > 1) {
+            // Построение: победители поддеревьев снизу вверх, проигравшие остаются в узлах
+            size_t* tree = nodes.m_data;
+            size_t* winners = nodes.m_data + m;
+            for (size_t i = 0; i < m; ++i) {
+                winners[m + i] = i;
+            }
+            for (size_t node = m - 1; node >= 1; --node) {
+                size_t a = winners[2 * node];
+                size_t b = winners[2 * node + 1];
+                bool a_wins = beats(a, b);
+                winners[node] = a_wins ? a : b;
+                tree[node] = a_wins ? b : a;
+            }
 
-        // Индекс последнего элемента, меньшего опорного
-        size_t i = low - 1;
+            size_t winner = winners[1];
+            size_t last_winner = m;
+            size_t wins = 0;
+            for (;;) {
+                wins = winner == last_winner ? wins + 1 : 1;
+                last_winner = winner;
+                if (wins < MIN_GALLOP) {
+                    *out++ = *head[winner]++;
+                }
+                else {
+                    // Второй по порядку -- лучший из проигравших на пути победителя к корню
+                    size_t second = tree[(winner + m) / 2];
+                    for (size_t node = (winner + m) / 4; node >= 1; node /= 2) {
+                        if (beats(tree[node], second)) {
+                            second = tree[node];
+                        }
+                    }
+                    size_t n = (size_t)(end[winner] - head[winner]);
+                    size_t count = winner < second
+                        ? gallop(head[winner], n, *head[second], [&comp](const T& x, const T& y) { return !comp(y, x); })
+                        : gallop(head[winner], n, *head[second], comp);
+                    VectorLegacyKernels::copy(out, head[winner], count, trivial);
+                    out += count;
+                    head[winner] += count;
+                    if (count < MIN_GALLOP) {
+                        wins = 0;
+                    }
+                }
+                if (head[winner] == end[winner]) {
+                    break;
+                }
+                // Новая голова диапазона проходит путь от листа к корню. Исход сравнений на случайных
+                // данных не предсказывается, поэтому обмен -- выбором без ветвления, а указатель на голову
+                // победителя переносится вместе с ним, без повторного чтения head
+                const T* value = head[winner];
+                for (size_t node = (winner + m) / 2; node >= 1; node /= 2) {
+                    size_t loser = tree[node];
+                    const T* other = head[loser];
+                    bool swap = comp(*other, *value) | (!comp(*value, *other) & (loser < winner));
+                    size_t mask = (size_t)0 - (size_t)swap;
+                    size_t flip = (loser ^ winner) & mask;
+                    tree[node] = loser ^ flip;
+                    winner ^= flip;
+                    value = swap ? other : value;
+                }
+            }
+            // Победитель закончился -- убираем его и строим дерево заново
+            --m;
+            for (size_t i = winner; i < m; ++i) {
+                head[i] = head[i + 1];
+                end[i] = end[i + 1];
+            }
+        }
+        if (m == 1) {
+            VectorLegacyKernels::copy(out, head[0], (size_t)(end[0] - head[0]), trivial);
+        }
+    }
 
-        // Проход по массиву
-        for (size_t j = low; j < high; j++) {
-            // Если текущий элемент меньше опорного
-            if (m_data[j] < pivot) {
-                i++;
-                std::swap(m_data[i], m_data[j]);
+    // Диапазоны входов слияния. Входы, не отсортированные по comp, сортируются в копиях (copies)
+    template <typename Compare>
+    static void merge_inputs(const VectorLegacy* inputs, size_t k, Compare comp, VectorLegacy<VectorLegacy>& copies,
+        VectorLegacy<const T*>& first, VectorLegacy<const T*>& last) {
+        copies.reserve_for(k);
+        first.reserve_for(k);
+        last.reserve_for(k);
+        for (size_t i = 0; i < k; ++i) {
+            const VectorLegacy* input = inputs + i;
+            // m_sorted не проверяется: после записи через [] он может быть устаревшим, а проверка
+            // все равно дешевле слияния. Во время переноса элементы входа не лежат подряд -- он тоже копируется
+            bool ordered = is_sorted(input->begin(), input->end(), comp);
+            if (!ordered || input->m_migration != nullptr) {
+                copies.m_data[copies.m_size] = *input;
+                if (!ordered) {
+                    copies.m_data[copies.m_size].sort_with(comp);
+                }
+                input = copies.m_data + copies.m_size++;
+            }
+            first.m_data[i] = input->m_data;
+            last.m_data[i] = input->m_data + input->m_size;
+        }
+        first.m_size = last.m_size = k;
+    }
+
+    // Значение с номером rank (rank меньше общего количества) в слиянии диапазонов.
+    // Для каждого диапазона бинарным поиском находится последний элемент, перед которым
+    // во всех диапазонах не больше rank элементов. Наибольший из таких элементов -- искомый
+    template <typename Compare>
+    static const T* merge_splitter(const T* const* first, const T* const* last, size_t k, size_t rank, Compare comp) {
+        auto rank_of = [&](const T& value) {
+            size_t before = 0;
+            for (size_t i = 0; i < k; ++i) {
+                before += (size_t)(lower_bound(first[i], last[i], value, comp) - first[i]);
+            }
+            return before;
+        };
+        const T* best = nullptr;
+        for (size_t i = 0; i < k; ++i) {
+            size_t lo = 0;
+            size_t hi = (size_t)(last[i] - first[i]);
+            // Ищем первый элемент, перед которым больше rank элементов
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (rank_of(first[i][mid]) <= rank) {
+                    lo = mid + 1;
+                }
+                else {
+                    hi = mid;
+                }
+            }
+            if (lo != 0 && (best == nullptr || comp(*best, first[i][lo - 1]))) {
+                best = first[i] + lo - 1;
             }
         }
+        return best;
+    }
 
-        // Размещение опорного элемента в правильном месте
-        std::swap(m_data[i + 1], m_data[high]);
+    // Слияние входов для merge_sorted и parallel_merge_sorted. В параллельном режиме результат делится
+    // на куски значениями-разделителями: элементы меньше разделителя идут в левый кусок из всех входов,
+    // поэтому куски сливаются независимо, а равные элементы не разделяются и порядок остается устойчивым
+    template <typename Compare>
+    static VectorLegacy merge_all(const VectorLegacy* inputs, size_t k, Compare comp, bool parallel) {
+        VectorLegacy<VectorLegacy> copies;
+        VectorLegacy<const T*> first;
+        VectorLegacy<const T*> last;
+        merge_inputs(inputs, k, comp, copies, first, last);
+        size_t total = 0;
+        for (size_t i = 0; i < k; ++i) {
+            total += (size_t)(last.m_data[i] - first.m_data[i]);
+        }
+        VectorLegacy result;
+        result.reserve_for(total);
+        size_t parts = parallel ? min(total / parallel_grain(), 4 * ThreadPool::instance().size()) : 1;
+        if (parts < 2) {
+            merge_k(first.m_data, last.m_data, k, result.m_data, comp);
+        }
+        else {
+            // bounds[j * k + i] -- начало куска j во входе i
+            VectorLegacy<size_t> bounds;
+            bounds.reserve_for((parts + 1) * k);
+            for (size_t i = 0; i < k; ++i) {
+                bounds.m_data[i] = 0;
+                bounds.m_data[parts * k + i] = (size_t)(last.m_data[i] - first.m_data[i]);
+            }
+            for (size_t j = 1; j < parts; ++j) {
+                const T* splitter = merge_splitter(first.m_data, last.m_data, k, total / parts * j, comp);
+                for (size_t i = 0; i < k; ++i) {
+                    bounds.m_data[j * k + i] = (size_t)(lower_bound(first.m_data[i], last.m_data[i], *splitter, comp) - first.m_data[i]);
+                }
+            }
+            T* out = result.m_data;
+            ThreadPool::instance().run(parts, [&](size_t part, size_t) {
+                VectorLegacy<const T*> from;
+                VectorLegacy<const T*> to;
+                from.reserve_for(k);
+                to.reserve_for(k);
+                size_t offset = 0;
+                for (size_t i = 0; i < k; ++i) {
+                    from.m_data[i] = first.m_data[i] + bounds.m_data[part * k + i];
+                    to.m_data[i] = first.m_data[i] + bounds.m_data[(part + 1) * k + i];
+                    offset += bounds.m_data[part * k + i];
+                }
+                merge_k(from.m_data, to.m_data, k, out + offset, comp);
+            });
+        }
+        result.m_size = total;
+        result.m_sorted = ascending(comp);
+        return result;
+    }
 
-        // Возврат индекса опорного элемента
-        return i + 1;
+    // Перестановка по индексам: на место i встает элемент order[i]. Один проход в новый буфер
+    void gather(const size_t* order) {
+        T* new_data = allocate(m_capacity);
+        if (shared()) {
+            for (size_t i = 0; i < m_size; ++i) {
+                new_data[i] = m_data[order[i]];
+            }
+        }
+        else {
+            for (size_t i = 0; i < m_size; ++i) {
+                new_data[i] = std::move(m_data[order[i]]);
+            }
+        }
+        replace_buffer(new_data, m_capacity);
+    }
+
+    // Поиск в отсортированном массиве: интерполяционный для чисел
+    size_t seek_sorted(const T& value, true_type) {
+        return seek_interpol(value);
     }
 
+    // Для остальных типов разность значений не определена -- бинарный поиск
+    size_t seek_sorted(const T& value, false_type) {
+        settle();
+        size_t index = (size_t)(lower_bound(m_data, m_data + m_size, value) - m_data);
+        return index < m_size && m_data[index] == value ? index : m_size;
+    }
 
     //Проверка сортированности массива по возрастанию.
     bool isSorted()
     {
+        settle();
         for (size_t i = 1; i < m_size; i++)
         {
             if (m_data[i] < m_data[i - 1])
@@ -193,6 +1121,251 @@ private:
         return m_sorted;
     }
 
+    // Обеспечивает вместимость не меньше n. Растет минимум вдвое, чтобы серия добавлений
+    // оставалась амортизированно линейной
+    void reserve_for(size_t n) {
+        if (n > m_capacity) {
+            resize(max(n, m_capacity * 2));
+        }
+    }
+
+    // Добавление диапазона в конец. Длина известна заранее -- не больше одного выделения памяти
+    template <typename It>
+    void append_range(It first, It last, forward_iterator_tag) {
+        size_t count = (size_t)distance(first, last);
+        reserve_for(m_size + count);
+        detach();
+        copy(first, last, m_data + m_size);
+        m_size += count;
+    }
+
+    // Однопроходные итераторы: длина неизвестна, вместимость растет геометрически
+    template <typename It>
+    void append_range(It first, It last, input_iterator_tag) {
+        detach();
+        for (; first != last; ++first) {
+            if (m_size == m_capacity) {
+                reserve_for(m_size + 1);
+            }
+            m_data[m_size++] = *first;
+        }
+    }
+
+    // Меньше этого числа элементов параллельные операции выполняются последовательно
+    static size_t parallel_grain() {
+        return 32768;
+    }
+
+    // Размер куска параллельной операции. Кратен строке кэша (64 байта), чтобы соседние куски
+    // выровненного буфера не делили строки между потоками. Не зависит от числа потоков,
+    // поэтому разбиение одинаково при любом запуске
+    static size_t parallel_chunk() {
+        size_t line = sizeof(T) < 64 && 64 % sizeof(T) == 0 ? 64 / sizeof(T) : 1;
+        return (parallel_grain() + line - 1) / line * line;
+    }
+
+    // Количество кусков для n элементов
+    static size_t parallel_chunks(size_t n) {
+        return (n + parallel_chunk() - 1) / parallel_chunk();
+    }
+
+    // Выполняет body(lo, hi, worker) для кусков [0, n) в пуле потоков
+    template <typename F>
+    static void for_range(size_t n, F body) {
+        size_t chunk = parallel_chunk();
+        ThreadPool::instance().run(parallel_chunks(n), [&](size_t task, size_t worker) {
+            size_t lo = task * chunk;
+            body(lo, min(n, lo + chunk), worker);
+        });
+    }
+
+    // Выполняет body(lo, hi, worker) для кусков [0, m_size) в пуле потоков.
+    // Изменяющие операции вызывают detach() заранее, константные читают куски через for_runs()
+    template <typename F>
+    void for_chunks(F body) const {
+        for_range(m_size, body);
+    }
+
+    /*
+    Заполнение и копирование буферов ядрами VectorLegacyKernels::fill и copy.
+    Тривиально копируемые буферы от copy_threshold() байт обрабатываются кусками в пуле потоков:
+    каждый поток первым касается своих страниц. Присваивание остальных типов может трогать общие
+    данные (счетчики ссылок, аллокатор), поэтому они копируются в одном потоке.
+    От stream_threshold() байт заполнение идет потоковыми записями мимо кэша: такой буфер в кэш все равно не помещается,
+    а обычная запись сначала читает каждую строку в кэш и вытесняет из него полезные данные.
+    */
+    static size_t copy_threshold() {
+        return 1024 * 1024;
+    }
+
+    static size_t stream_threshold() {
+        return 32 * 1024 * 1024;
+    }
+
+    // Заполнение n элементов буфера dst значением value
+    static void fill_buffer(T* dst, size_t n, const T& value) {
+        typename is_trivially_copyable<T>::type trivial;
+        bool stream = n >= stream_threshold() / sizeof(T);
+        if (!trivial || n < copy_threshold() / sizeof(T)) {
+            VectorLegacyKernels::fill(dst, n, value, stream, trivial);
+            return;
+        }
+        for_range(n, [&](size_t lo, size_t hi, size_t) {
+            VectorLegacyKernels::fill(dst + lo, hi - lo, value, stream, trivial);
+        });
+    }
+
+    // Копирование n элементов из src в dst
+    static void copy_buffer(T* dst, const T* src, size_t n) {
+        typename is_trivially_copyable<T>::type trivial;
+        if (!trivial || n < copy_threshold() / sizeof(T)) {
+            VectorLegacyKernels::copy(dst, src, n, trivial);
+            return;
+        }
+        for_range(n, [&](size_t lo, size_t hi, size_t) {
+            VectorLegacyKernels::copy(dst + lo, src + lo, hi - lo, trivial);
+        });
+    }
+
+    // Перенос элементов в новый буфер new_data перед отказом от текущего. Собственный буфер
+    // больше не нужен -- элементы перемещаются, разделенный (копирование при записи) копируется
+    void relocate(T* new_data) {
+        if (shared()) {
+            copy_buffer(new_data, m_data, m_size);
+        }
+        else {
+            move_buffer(new_data, m_data, m_size, typename is_trivially_copyable<T>::type());
+        }
+    }
+
+    static void move_buffer(T* dst, T* src, size_t n, true_type) {
+        copy_buffer(dst, src, n);
+    }
+
+    static void move_buffer(T* dst, T* src, size_t n, false_type) {
+        std::move(src, src + n, dst);
+    }
+
+    // Сжатие на месте: остаются элементы, для которых pred ложно, в прежнем порядке. Возвращает их количество.
+    // Тривиально копируемые элементы переносятся без ветвления: каждый пишется на позицию записи,
+    // а позиция сдвигается, только если элемент остается. Поэтому удаление вразброс не сбивает
+    // предсказание переходов
+    template <typename Predicate>
+    static size_t compact(T* data, size_t n, Predicate& pred, true_type) {
+        size_t write = 0;
+        for (size_t i = 0; i < n; ++i) {
+            T value = data[i];
+            data[write] = value;
+            write += !pred(value);
+        }
+        return write;
+    }
+
+    template <typename Predicate>
+    static size_t compact(T* data, size_t n, Predicate& pred, false_type) {
+        size_t write = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (!pred(data[i])) {
+                if (write != i) {
+                    data[write] = std::move(data[i]);
+                }
+                ++write;
+            }
+        }
+        return write;
+    }
+
+#ifdef VECTORLEGACY_SSSE3
+    // Для каждой маски оставляемых 32-битных полос: перестановка байт, собирающая эти полосы в начало, и их число
+    struct CompressTable {
+        __m128i shuffle[16];
+        unsigned char count[16];
+
+        CompressTable() {
+            for (int mask = 0; mask < 16; ++mask) {
+                unsigned char bytes[16];
+                memset(bytes, 0x80, sizeof(bytes));
+                int lanes = 0;
+                for (int lane = 0; lane < 4; ++lane) {
+                    if (mask & (1 << lane)) {
+                        for (int b = 0; b < 4; ++b) {
+                            bytes[4 * lanes + b] = (unsigned char)(4 * lane + b);
+                        }
+                        ++lanes;
+                    }
+                }
+                shuffle[mask] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+                count[mask] = (unsigned char)lanes;
+            }
+        }
+    };
+
+    static const CompressTable& compress_table() {
+        static const CompressTable table;
+        return table;
+    }
+
+    // Маска совпадающих полос: числа с плавающей точкой сравниваются как числа (0.0 == -0.0, NaN != NaN)
+    static int equal_lanes(__m128i x, __m128i v, true_type) {
+        return _mm_movemask_ps(_mm_cmpeq_ps(_mm_castsi128_ps(x), _mm_castsi128_ps(v)));
+    }
+
+    static int equal_lanes(__m128i x, __m128i v, false_type) {
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, v)));
+    }
+#endif
+
+    // Удаление всех вхождений value из 32-битных чисел. С SSSE3 числа сравниваются по 4,
+    // а оставшиеся сдвигаются в начало одной перестановкой байт по таблице
+    static size_t compact_equal(T* data, size_t n, const T& value, true_type) {
+        size_t write = 0;
+        size_t i = 0;
+#ifdef VECTORLEGACY_SSSE3
+        const CompressTable& table = compress_table();
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        __m128i v = _mm_set1_epi32((int)bits);
+        typename is_floating_point<T>::type floating;
+        for (; i + 4 <= n; i += 4) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            int keep = ~equal_lanes(x, v, floating) & 15;
+            // Запись не дальше прочитанного: write <= i
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + write), _mm_shuffle_epi8(x, table.shuffle[keep]));
+            write += table.count[keep];
+        }
+#endif
+        for (; i < n; ++i) {
+            T x = data[i];
+            data[write] = x;
+            write += !(x == value);
+        }
+        return write;
+    }
+
+    static size_t compact_equal(T* data, size_t n, const T& value, false_type) {
+        auto equal = [&value](const T& x) { return x == value; };
+        return compact(data, n, equal, is_trivially_copyable<T>());
+    }
+
+    // Сброс n элементов при очистке: тривиально разрушаемым типам не нужен
+    static void clear_kernel(T*, size_t, true_type) {
+    }
+
+    // Нетривиальные элементы (строки и т.п.) сразу освобождают свои ресурсы
+    static void clear_kernel(T* data, size_t n, false_type) {
+        for (size_t i = 0; i < n; ++i) {
+            data[i] = T();
+        }
+    }
+
+    // Новый размер после удаления элементов: освободившиеся места сбрасываются, как при clear. Возвращает число удаленных
+    size_t shrink_to(size_t size) {
+        size_t removed = m_size - size;
+        clear_kernel(m_data + size, removed, is_trivially_destructible<T>());
+        m_size = size;
+        return removed;
+    }
+
 public:
 //-----------------------------------ПРАВИЛО ПЯТИ--------------------------------
     // Конструктор по умолчанию
@@ -201,15 +1374,26 @@ public:
         m_capacity = 0;
         m_data = nullptr;
         m_sorted = false;
+        m_refs = nullptr;
+        m_migration = nullptr;
+        m_growth_step = 0;
+        m_alignment = 0;
+        m_huge_pages = false;
+        m_index = nullptr;
     }
 
 
     //Конструктор с передачей элементов через список
-    template <typename T>
     VectorLegacy(initializer_list<T> list) {
+        m_refs = nullptr;
+        m_migration = nullptr;
+        m_growth_step = 0;
+        m_alignment = 0;
+        m_huge_pages = false;
+        m_index = nullptr;
         m_size = list.size();
         m_capacity = m_size;
-        m_data = new T[m_size];
+        m_data = allocate(m_size);
         //
         copy(list.begin(), list.end(), m_data);
         //copy_n(list.begin(), m_size, m_data);
@@ -220,11 +1404,19 @@ public:
 
     // Конструктор с указанием размера. Если не указать, каким значением заполнять, заполнится 0
     VectorLegacy(size_t n, const T& value = 0) {
+        m_refs = nullptr;
+        m_migration = nullptr;
+        m_growth_step = 0;
+        m_alignment = 0;
+        m_huge_pages = false;
+        m_index = nullptr;
         m_size = n;
         m_capacity = n*2;
-        m_data = new T[m_capacity];
-        for (size_t i = 0; i < n; ++i) {
-            m_data[i] = value;
+        m_data = allocate(m_capacity);
+        // Свежее отображение ядро уже заполнило нулями
+        unsigned char byte;
+        if (!(use_map(m_capacity) && VectorLegacyKernels::uniform_bytes(value, byte, is_trivially_copyable<T>()) && byte == 0)) {
+            fill_buffer(m_data, n, value);
         }
         m_sorted = true;
     }
@@ -233,15 +1425,38 @@ public:
 
     // Конструктор с указанием элементов из динамического массива
     VectorLegacy(const T* data, size_t n) {
+        m_refs = nullptr;
+        m_migration = nullptr;
+        m_growth_step = 0;
+        m_alignment = 0;
+        m_huge_pages = false;
+        m_index = nullptr;
         m_size = n;
         m_capacity = n;
-        m_data = new T[n];
+        m_data = allocate(n);
         //copy_n(data, n, m_data);
-        copy(data, data+n, m_data);
+        copy_buffer(m_data, data, n);
         m_sorted = isSorted();
         //memcpy(m_data, data, n * sizeof(T));
     }
 
+    // Конструктор из диапазона итераторов. Для прямых итераторов память выделяется один раз.
+    // Целые типы исключены, чтобы VectorLegacy<int>(5, 1) вызывал конструктор с размером
+    template <typename It, typename = typename enable_if<!is_integral<It>::value>::type>
+    VectorLegacy(It first, It last) {
+        m_refs = nullptr;
+        m_migration = nullptr;
+        m_growth_step = 0;
+        m_alignment = 0;
+        m_huge_pages = false;
+        m_index = nullptr;
+        m_size = 0;
+        m_capacity = 0;
+        m_data = nullptr;
+        append_range(first, last, typename iterator_traits<It>::iterator_category());
+        m_sorted = isSorted();
+    }
+
     //Конструктор перемещения
     VectorLegacy(VectorLegacy&& other) {
         // Перемещение данных
@@ -249,47 +1464,59 @@ public:
         m_size = other.m_size;
         m_capacity = other.m_capacity;
         m_sorted = other.m_sorted;
+        m_refs = other.m_refs;
+        m_migration = other.m_migration;
+        m_growth_step = other.m_growth_step;
+        m_alignment = other.m_alignment;
+        m_huge_pages = other.m_huge_pages;
+        m_index = other.m_index;
 
         // Обнуление данных other
         other.m_sorted = false;
         other.m_data = nullptr;
         other.m_size = 0;
         other.m_capacity = 0;
-
-
+        other.m_refs = nullptr;
+        other.m_migration = nullptr;
+        other.m_index = nullptr;
     }
 
-    //Оператор копирования
+    //Оператор копирования. Копия массива в режиме копирования при записи разделяет его буфер
     VectorLegacy& operator=(const VectorLegacy<T>& other) {
         if (this != &other) {
             // Освобождение памяти
-            if (m_data != nullptr) {
-                delete[] m_data;
-            }
+            release();
 
             // Копирование данных
             m_size = other.m_size;
             m_capacity = other.m_capacity;
             m_sorted = other.m_sorted;
-            m_data = new T[m_capacity];
+            m_refs = other.m_refs;
+            m_growth_step = other.m_growth_step;
+            m_alignment = other.m_alignment;
+            m_huge_pages = other.m_huge_pages;
+            // Индекс копии строится заново при первом поиске
+            delete m_index;
+            m_index = other.m_index != nullptr ? other.m_index->clone_empty() : nullptr;
+            if (m_refs != nullptr) {
+                m_refs->fetch_add(1, memory_order_relaxed);
+                m_data = other.m_data;
+                return *this;
+            }
+            m_data = allocate(m_capacity);
             //copy_n(other.m_data, other.m_size, m_data, other.m_size);
             //memcpy(m_data, other.m_data, other.m_size * sizeof(T));
-            copy(other.begin(), other.end(), m_data);
+            other.copy_to(m_data);
         }
         return *this;
     }
     //Оператор копирования (списка)
     VectorLegacy& operator=(const initializer_list<T>& list) {
-        // Освобождение памяти
-        if (m_data != nullptr) {
-            delete[] m_data;
-        }
+        // Замена буфера (старый освобождается)
+        replace_buffer(allocate(list.size() * 2), list.size() * 2);
 
         // Копирование данных из списка
         m_size = list.size();
-        m_capacity = m_size * 2;
-        m_data = new T[m_capacity];
-        size_t i = 0;
         copy(list.begin(), list.end(), m_data);
         m_sorted = isSorted();
         return *this;
@@ -299,29 +1526,51 @@ public:
     VectorLegacy& operator=(VectorLegacy<T>&& other) noexcept {
         if (this != &other) {
             // Перемещение данных
-            delete[] m_data;
+            release();
             m_data = other.m_data;
             m_size = other.m_size;
             m_capacity = other.m_capacity;
             m_sorted = other.m_sorted;
+            m_refs = other.m_refs;
+            m_migration = other.m_migration;
+            m_growth_step = other.m_growth_step;
+            m_alignment = other.m_alignment;
+            m_huge_pages = other.m_huge_pages;
+            delete m_index;
+            m_index = other.m_index;
 
             // Обнуление данных other
             other.m_sorted = false;
             other.m_data = nullptr;
             other.m_size = 0;
             other.m_capacity = 0;
+            other.m_refs = nullptr;
+            other.m_migration = nullptr;
+            other.m_index = nullptr;
         }
         return *this;
     }
-    //Конструктор копирования
+    //Конструктор копирования. В режиме копирования при записи -- О(1), буфер разделяется
     VectorLegacy(const VectorLegacy<T>& other) {
         m_size = other.m_size;
         m_sorted = other.m_sorted;
+        m_refs = other.m_refs;
+        m_migration = nullptr;
+        m_growth_step = other.m_growth_step;
+        m_alignment = other.m_alignment;
+        m_huge_pages = other.m_huge_pages;
+        m_index = other.m_index != nullptr ? other.m_index->clone_empty() : nullptr;
+        if (m_refs != nullptr) {
+            m_refs->fetch_add(1, memory_order_relaxed);
+            m_data = other.m_data;
+            m_capacity = other.m_capacity;
+            return;
+        }
         m_capacity = other.m_size;
-        m_data = new T[m_capacity];
+        m_data = allocate(m_capacity);
         //copy_n(other.m_data, other.m_size, m_data, other.m_size);
         //memcpy(m_data, other.m_data, m_size * sizeof(T));
-        copy(other.begin(), other.end(), m_data);
+        other.copy_to(m_data);
     }
 
     //Обмен массивов местами
@@ -339,6 +1588,12 @@ public:
         std::swap(m_size, other.m_size);
         std::swap(m_capacity, other.m_capacity);
         std::swap(m_sorted, other.m_sorted);
+        std::swap(m_refs, other.m_refs);
+        std::swap(m_migration, other.m_migration);
+        std::swap(m_growth_step, other.m_growth_step);
+        std::swap(m_alignment, other.m_alignment);
+        std::swap(m_huge_pages, other.m_huge_pages);
+        std::swap(m_index, other.m_index);
 
         // Обновление ссылок на `nullptr` для объектов, 
         // которые больше не владеют буфером данных
@@ -360,10 +1615,8 @@ public:
 
     // Деструктор
     ~VectorLegacy() {
-        if (m_data != nullptr)
-        {
-        delete[] m_data;
-        }
+        release();
+        delete m_index;
     }
 //----------------------------------------------------------------------------------------
     //Оператор сравнения
@@ -372,9 +1625,8 @@ public:
         if (m_size != other.m_size) {
             return false;
         }
-
         for (size_t i = 0; i < m_size; ++i) {
-            if (m_data[i] != other.m_data[i]) {
+            if (element(i) != other.element(i)) {
                 return false;
             }
         }
@@ -390,7 +1642,9 @@ public:
         }
         else
         {
-            return m_data[index];
+            invalidate_index();
+            step();
+            return element(index);
         }
     }
     
@@ -401,7 +1655,7 @@ public:
         }
         else
         {
-        return m_data[index];
+        return element(index);
         }
     }
 
@@ -420,27 +1674,162 @@ public:
         return m_sorted;
     }
 
+    //Включает режим копирования при записи: копии этого массива (и копии копий) за О(1)
+    //разделяют буфер, а первое изменение любой из них копирует его. Счетчик ссылок атомарный,
+    //поэтому копии-снимки можно читать в других потоках, пока владелец продолжает работу
+    void enable_cow() {
+        settle();
+        if (m_refs == nullptr) {
+            m_refs = new atomic<size_t>(1);
+        }
+    }
+
+    //Выключает режим: массив получает собственный буфер, дальнейшие копии снова глубокие
+    void disable_cow() {
+        if (m_refs != nullptr) {
+            detach();
+            delete m_refs;
+            m_refs = nullptr;
+        }
+    }
+
+    //Включен ли режим копирования при записи
+    bool cow() const
+    {
+        return m_refs != nullptr;
+    }
+
+    //Включает постепенный рост: при перевыделении элементы не копируются разом, а переносятся
+    //в новый буфер по step штук за каждую следующую операцию push_back, pop_back, [], at, back.
+    //Пока перенос идет, эти операции читают элементы из обоих буферов, поэтому ни одна из них не
+    //делает больше О(step) работы (шаг растет, только если иначе перенос не успеет закончиться до
+    //следующего роста). Остальные методы сначала завершают перенос целиком.
+    //Ссылки на элементы, полученные во время переноса, действительны до следующей операции.
+    //Не сочетается с копированием при записи: в этом режиме массив растет как обычно
+    void enable_incremental_growth(size_t step = 4096) {
+        m_growth_step = max(step, (size_t)1);
+    }
+
+    //Выключает постепенный рост, незавершенный перенос завершается
+    void disable_incremental_growth() {
+        settle();
+        m_growth_step = 0;
+    }
+
+    //Шаг постепенного роста, 0 -- режим выключен
+    size_t incremental_growth() const
+    {
+        return m_growth_step;
+    }
+
+    //Средний: О(n), буфер перевыделяется
+    //Выравнивание буфера по границе alignment байт (степень двойки, не меньше 64 -- строки кэша),
+    //чтобы ядра на SIMD могли читать выровненными загрузками. 0 -- обычное выделение.
+    //Сохраняется при росте, перемещении и копировании массива
+    void set_alignment(size_t alignment) {
+        if (alignment & (alignment - 1)) {
+            throw invalid_argument("Alignment must be a power of two");
+        }
+        relayout(alignment == 0 ? 0 : max(alignment, (size_t)64), m_huge_pages);
+    }
+
+    //Выравнивание буфера в байтах, 0 -- обычное выделение
+    size_t alignment() const
+    {
+        return m_alignment;
+    }
+
+    //Средний: О(n), буфер перевыделяется
+    //Режим больших страниц (только Linux): отображенные буферы (от map_threshold() байт, тривиально
+    //копируемые типы) выравниваются по 2 МБ, занимают целые большие страницы и помечаются
+    //madvise(MADV_HUGEPAGE). Меньше промахов TLB при проходах по большим массивам.
+    //Сохраняется при росте (mremap), перемещении и копировании массива
+    void enable_huge_pages() {
+        relayout(m_alignment, true);
+    }
+
+    //Выключает режим больших страниц
+    void disable_huge_pages() {
+        relayout(m_alignment, false);
+    }
+
+    //Включен ли режим больших страниц
+    bool huge_pages() const
+    {
+        return m_huge_pages;
+    }
+
+    //Средний: О(1)
+    //Включает хеш-индекс: seek за О(1) в среднем без изменения порядка элементов.
+    //push_back, pop_back и swap обновляют индекс за О(1), insert, delete_ и pop_front -- за О(n)
+    //вместе со сдвигом элементов. После остальных изменений индекс перестраивается при следующем seek.
+    //Неконстантные [], at, back и data считаются записью и помечают индекс устаревшим; чтение без
+    //перестройки индекса -- через константный массив. Запись через ссылки и срезы, полученные до seek,
+    //индекс не видит: после нее нужно вызвать invalidate_index.
+    //Hash -- хеш-функция значений, нужен еще operator==
+    template <typename Hash = hash<T>>
+    void enable_index() {
+        if (m_index == nullptr) {
+            m_index = new VectorLegacyHashIndex<T, Hash>();
+        }
+    }
+
+    //Средний: О(1)
+    //Помечает индекс устаревшим после записи через ссылки или срезы: следующий seek перестроит его
+    void invalidate_index() {
+        if (m_index != nullptr) {
+            m_index->invalidate();
+        }
+    }
+
+    //Выключает индекс и освобождает его память
+    void disable_index() {
+        delete m_index;
+        m_index = nullptr;
+    }
+
+    //Включен ли индекс
+    bool indexed() const
+    {
+        return m_index != nullptr;
+    }
+
 //----------------------------------------------------------------Добавление и удаление элементов--------------------------------------------------
     // Добавление элемента в конец
     // Средний: O(1)
     // Худший: О(n)
     void push_back(const T& value) {
+        bool indexed = index_fresh();
         if (m_size == m_capacity) {
             resize();
         }
+        step();
         m_data[m_size++] = value;
         m_sorted = false;
+        if (indexed) {
+            m_index->appended(m_data, m_size);
+        }
     }
     //Средний:  О(n)
     // Удаление элемента из конца
     T pop_back() {
-        T result = m_data[m_size - 1];
+        bool indexed = index_fresh();
+        step();
+        T result = element(m_size - 1);
         --m_size;
+        // Снятый элемент больше не переносится
+        if (m_migration != nullptr && m_migration->count > m_size) {
+            m_migration->count = max(m_migration->moved, m_size);
+            migrate(0);
+        }
         //Если размер в четыре раза меньше емкости, уменьшаем емкость в 2 раза
         if (m_size <= (m_capacity / 4))
         {
             this->resize(m_capacity/2); 
         }
+        if (indexed) {
+            m_index->erased(result, m_size, m_data, m_size);
+        }
         return result;
     }
     //Средний: О(n)
@@ -449,8 +1838,14 @@ public:
         if (m_size == 0) {
             throw out_of_range("Array is empty");
         }
+        bool indexed = index_fresh();
+        detach();
+        T removed = indexed ? m_data[0] : T();
         shift_left(0, 1);
         --m_size;
+        if (indexed) {
+            m_index->erased(removed, 0, m_data, m_size);
+        }
     }
     //Средний: О(n)
     // Добавление элемента в начало
@@ -458,6 +1853,7 @@ public:
         if (m_size == m_capacity) {
             resize();
         }
+        detach();
 
         shift_right(0, 1);
         m_data[0] = value;
@@ -472,14 +1868,19 @@ public:
             throw out_of_range("Index out of range");
         }
 
+        bool indexed = index_fresh();
         if (m_size == m_capacity) {
             resize();
         }
+        detach();
 
         shift_right(index, 1);
         m_data[index] = value;
         m_size++;
         m_sorted = false;
+        if (indexed) {
+            m_index->inserted(m_data, m_size, index);
+        }
     }
     //Средний: О(n)
     //     //Лучший: О(1)
@@ -491,9 +1892,9 @@ public:
 
         size_t new_size = m_size + count;
         if (new_size > m_capacity) {
-            m_capacity = new_size * 2;
-            resize(m_capacity);
+            resize(new_size * 2);
         }
+        detach();
 
         // Сдвиг элементов вправо
         for (size_t i = m_size - 1; i >= index; --i) {
@@ -517,9 +1918,9 @@ public:
 
         size_t new_size = m_size + list.size();
         if (new_size > m_capacity) {
-            m_capacity = new_size * 2;
-            resize(m_capacity);
+            resize(new_size * 2);
         }
+        detach();
 
         // Сдвиг элементов вправо
         for (size_t i = m_size - 1; i >= index; --i) {
@@ -534,11 +1935,77 @@ public:
         m_size = new_size;
         m_sorted = false;
     }
-    //Средний: О(n)
-    // Очистка массива
+    //Средний: О(m)
+    //Добавляет диапазон [first, last) в конец. Диапазон не должен указывать в сам массив
+    template <typename It>
+    void append(It first, It last) {
+        append_range(first, last, typename iterator_traits<It>::iterator_category());
+        m_sorted = false;
+    }
+    //Средний: О(m)
+    //Добавляет все элементы other в конец за одно выделение памяти. Можно передать сам массив
+    void append(const VectorLegacy& other) {
+        size_t count = other.m_size;
+        if (count == 0) {
+            return;
+        }
+        settle();
+        // Отсортированность сохраняется, если other продолжает порядок
+        bool sorted = m_size == 0 ? other.m_sorted
+            : m_sorted && other.m_sorted && !(other.element(0) < m_data[m_size - 1]);
+        reserve_for(m_size + count);
+        detach();
+        T* dst = m_data + m_size;
+        other.for_runs(0, count, [&](const T* p, size_t n) {
+            dst = copy(p, p + n, dst);
+        });
+        m_size += count;
+        m_sorted = sorted;
+    }
+    //Средний: О(m)
+    //Добавляет элементы other в конец перемещением, other остается пустым.
+    //Разделенный буфер (копирование при записи) и сам массив копируются, как в append(const VectorLegacy&)
+    void append(VectorLegacy&& other) {
+        if (&other == this || other.shared()) {
+            append(static_cast<const VectorLegacy&>(other));
+        }
+        else if (other.m_size != 0) {
+            size_t count = other.m_size;
+            settle();
+            other.settle();
+            bool sorted = m_size == 0 ? other.m_sorted
+                : m_sorted && other.m_sorted && !(other.m_data[0] < m_data[m_size - 1]);
+            reserve_for(m_size + count);
+            detach();
+            std::move(other.m_data, other.m_data + count, m_data + m_size);
+            m_size += count;
+            m_sorted = sorted;
+        }
+        if (&other != this) {
+            other.clear();
+        }
+    }
+    //Средний: О(m)
+    //Заменяет содержимое диапазоном [first, last). Память перевыделяется, только если не хватает вместимости
+    template <typename It>
+    void assign(It first, It last) {
+        m_size = 0;
+        append_range(first, last, typename iterator_traits<It>::iterator_category());
+        m_sorted = isSorted();
+    }
+    //Средний: О(1) для тривиально разрушаемых типов, иначе О(n)
+    // Очистка массива. Вместимость сохраняется
     void clear() {
-        for (size_t i = 0; i < m_size; ++i) {
-            m_data[i] = 0;
+        if (m_index != nullptr) {
+            m_index->invalidate();
+        }
+        if (shared()) {
+            // Разделенный буфер не копируем -- его содержимое все равно не нужно
+            replace_buffer(allocate(m_capacity), m_capacity);
+        }
+        else {
+            settle();
+            clear_kernel(m_data, m_size, is_trivially_destructible<T>());
         }
         m_size = 0;
         m_sorted = false;
@@ -550,6 +2017,9 @@ public:
         if (index >= m_size) {
             throw out_of_range("Invalid index");
         }
+        bool indexed = index_fresh();
+        detach();
+        T removed = indexed ? m_data[index] : T();
 
         // Сдвиг элементов влево
         for (size_t i = index; i < m_size - 1; ++i) {
@@ -557,6 +2027,9 @@ public:
         }
 
         --m_size;
+        if (indexed) {
+            m_index->erased(removed, index, m_data, m_size);
+        }
     }
     //Средний: О(n)
     //     //Лучший: О(1)
@@ -565,6 +2038,7 @@ public:
         if (index + count > m_size) {
             throw out_of_range("Invalid index or count");
         }
+        detach();
 
         // Сдвиг элементов влево
         for (size_t i = index + count; i < m_size; ++i) {
@@ -573,13 +2047,70 @@ public:
 
         m_size -= count;
     }
+    //Средний: О(n)
+    //Удаляет за один проход все элементы, для которых pred(элемент) истинно. Порядок остальных
+    //не меняется, поэтому отсортированный массив остается отсортированным. Возвращает число удаленных
+    template <typename Predicate>
+    size_t remove_if(Predicate pred) {
+        detach();
+        size_t count = compact(m_data, m_size, pred, is_trivially_copyable<T>());
+        return shrink_to(count);
+    }
+    //Средний: О(n), для отсортированного массива О(log(n)) поиска + один сдвиг хвоста
+    //Удаляет все элементы, равные value. Возвращает число удаленных
+    size_t erase_value(const T& value) {
+        detach();
+        if (m_sorted) {
+            T* first = lower_bound(m_data, m_data + m_size, value);
+            T* last = upper_bound(first, m_data + m_size, value);
+            std::move(last, m_data + m_size, first);
+            return shrink_to(m_size - (size_t)(last - first));
+        }
+        integral_constant<bool, is_arithmetic<T>::value && sizeof(T) == 4> simd;
+        return shrink_to(compact_equal(m_data, m_size, value, simd));
+    }
+    //Средний: О(n)
+    //Удаляет элементы с позиций indices[0], ..., indices[count - 1] (по неубыванию, повторы удаляются один раз)
+    //за один проход: промежутки между удаляемыми позициями сдвигаются целиком. Возвращает число удаленных.
+    //Неверный список (позиция вне массива, нарушен порядок) отвергается до каких-либо изменений
+    size_t erase_indices(const size_t* indices, size_t count) {
+        for (size_t j = 0; j < count; ++j) {
+            if (indices[j] >= m_size) {
+                throw out_of_range("Invalid index");
+            }
+            if (j != 0 && indices[j] < indices[j - 1]) {
+                throw invalid_argument("Indices must be sorted");
+            }
+        }
+        if (count == 0) {
+            return 0;
+        }
+        detach();
+        size_t write = indices[0];
+        size_t read = indices[0];
+        for (size_t j = 0; j < count; ++j) {
+            if (indices[j] < read) {
+                continue;
+            }
+            std::move(m_data + read, m_data + indices[j], m_data + write);
+            write += indices[j] - read;
+            read = indices[j] + 1;
+        }
+        std::move(m_data + read, m_data + m_size, m_data + write);
+        return shrink_to(write + (m_size - read));
+    }
+
+    size_t erase_indices(const VectorLegacy<size_t>& indices) {
+        VectorLegacy<size_t> scratch;
+        return erase_indices(indices.contiguous(scratch), indices.size());
+    }
 //-----------------------------------------------------------------------------------------------------------------------------------
     // Печать элементов
     void print() const {
         //Выводит последний элемент
         cout << "[";
         for (size_t i = 0; i < m_size; ++i) {
-            cout << m_data[i] << ", ";
+            cout << element(i) << ", ";
         }
         cout << "]" << endl;
     }
@@ -589,7 +2120,7 @@ public:
         stringstream ss;
         ss << "[";
         for (size_t i = 0; i < m_size; ++i) {
-            ss << m_data[i];
+            ss << element(i);
             if (i != m_size - 1) {
                 ss << ", ";
             }
@@ -604,7 +2135,9 @@ public:
         {
             throw out_of_range("Tried to access to index out of range (array size)");
         }
-        return m_data[index];
+        invalidate_index();
+        step();
+        return element(index);
         m_sorted = false;
     }
     // Доступ к элементу по индексу (только чтение)
@@ -612,13 +2145,15 @@ public:
         if (index > m_size) {
             throw out_of_range("Tried to access to index out of range (array size)");
         }
-        return m_data[index];
+        return element(index);
     }
     //Обмен элементов массивов местами
     void swap(size_t index1, size_t index2) {
         if (index1 >= m_size || index2 >= m_size) {
             throw out_of_range("Invalid index");
         }
+        bool indexed = index_fresh();
+        detach();
 
         // Временная переменная для хранения значения
         T temp = m_data[index1];
@@ -627,6 +2162,9 @@ public:
         m_data[index1] = m_data[index2];
         m_data[index2] = temp;
         m_sorted = false;
+        if (indexed) {
+            m_index->swapped(m_data, index1, index2);
+        }
     }
     //Средний: О(log(log(n))
     //Поиск value интеополяционно. Сортирует массив по возрастанию, если он не отсортирован
@@ -636,34 +2174,14 @@ public:
             throw std::runtime_error("Array is not sorted");
         }
 
-        if (m_size == 0  || m_data[0] > value  || m_data[m_size - 1] < value) {
-            return m_size;
-        }
-
-        size_t left = 0;
-        size_t right = m_size - 1;
-
-        while (left <= right) {
-            size_t mid = left + ((right - left) * (value - m_data[left])) / (m_data[right] - m_data[left]);
-
-            if (m_data[mid] == value) {
-                return mid;
-            }
-            else if (m_data[mid] < value) {
-                left = mid + 1;
-            }
-            else {
-                right = mid - 1;
-            }
-        }
-
-        return m_size;
+        settle();
+        return VectorLegacyKernels::seek_interpol(m_data, m_size, value);
     }
     //Средний: О(n)
     //Последовательный поиск
     size_t seek_sequentional(const T& value) const {
         for (size_t i = 0; i < m_size; ++i) {
-            if (m_data[i] == value) {
+            if (element(i) == value) {
                 return i;
             }
         }
@@ -671,31 +2189,35 @@ public:
         return m_size;
     }
     //Сортировать массив пользователя без спроса -- плохая идея.
+    //С включенным индексом (enable_index) поиск идет по хешу, после массовых изменений индекс перестраивается
     size_t seek(const T& value)
     {
+        if (m_index != nullptr)
+        {
+            if (!m_index->fresh()) {
+                settle();
+                m_index->rebuild(m_data, m_size);
+            }
+            size_t position = m_index->find(value);
+            return position == VectorLegacyIndex<T>::npos ? m_size : position;
+        }
         if (!m_sorted)
         {
             return seek_sequentional(value);
         }
         else
         {
-            return seek_interpol(value);
+            return seek_sorted(value, is_arithmetic<T>());
         }
             
     }
     //Средний, Худший: O(n*n), Лучший О(n)
     //Сортировка вставками. Необходима для сортировки
-    void sort_insertion(size_t lo, size_t hi) {
-        for (size_t i = lo + 1; i < hi; ++i) {
-            T value = m_data[i];
-            size_t j = i;
-            while (j > lo && m_data[j - 1] > value) {
-                m_data[j] = m_data[j - 1];
-                --j;
-            }
-            m_data[j] = value;
-        }
-        m_sorted = true;
+    template <typename Compare = less<T>>
+    void sort_insertion(size_t lo, size_t hi, Compare comp = Compare()) {
+        detach();
+        VectorLegacyKernels::sort_insertion(m_data, lo, hi, comp);
+        m_sorted = ascending(comp);
     }
 
     //Если массив пустой...
@@ -707,27 +2229,120 @@ public:
         if (m_size == 0) {
             throw std::out_of_range("Vector is empty");
         }
+        invalidate_index();
+        step();
 
-        return m_data[m_size - 1];
+        return element(m_size - 1);
     }
     //Ссылка на первый элемент 
     T& data() {
         if (m_size == 0) {
             throw std::out_of_range("Vector is empty");
         }
+        detach();
 
         return m_data[0];
     }
-    //Указатель на начало массива
-    const T* begin() const {
+    //Указатель на начало массива. Незавершенный перенос (enable_incremental_growth) завершается
+    const T* begin() {
+        settle();
         return m_data;
     }
 
     //Указатель на конец массива
-    const T* end() const {
+    const T* end() {
+        settle();
         return m_data + m_size;
     }
 
+    //Итератор константного массива. Элементы читаются через element(), поэтому обход
+    //не завершает перенос и может идти из нескольких потоков одновременно
+    class const_iterator {
+    public:
+        typedef random_access_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const T* pointer;
+        typedef const T& reference;
+
+        const_iterator() : m_owner(nullptr), m_index(0) {}
+        const_iterator(const VectorLegacy* owner, size_t index) : m_owner(owner), m_index(index) {}
+
+        reference operator*() const { return m_owner->element(m_index); }
+        pointer operator->() const { return &m_owner->element(m_index); }
+        reference operator[](difference_type n) const { return m_owner->element(m_index + n); }
+
+        const_iterator& operator++() { ++m_index; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++m_index; return old; }
+        const_iterator& operator--() { --m_index; return *this; }
+        const_iterator operator--(int) { const_iterator old = *this; --m_index; return old; }
+        const_iterator& operator+=(difference_type n) { m_index += n; return *this; }
+        const_iterator& operator-=(difference_type n) { m_index -= n; return *this; }
+        const_iterator operator+(difference_type n) const { return const_iterator(m_owner, m_index + n); }
+        friend const_iterator operator+(difference_type n, const const_iterator& it) { return it + n; }
+        const_iterator operator-(difference_type n) const { return const_iterator(m_owner, m_index - n); }
+        difference_type operator-(const const_iterator& other) const { return (difference_type)m_index - (difference_type)other.m_index; }
+
+        bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+        bool operator<(const const_iterator& other) const { return m_index < other.m_index; }
+        bool operator>(const const_iterator& other) const { return m_index > other.m_index; }
+        bool operator<=(const const_iterator& other) const { return m_index <= other.m_index; }
+        bool operator>=(const const_iterator& other) const { return m_index >= other.m_index; }
+
+    private:
+        const VectorLegacy* m_owner;
+        size_t m_index;
+    };
+
+    //Начало константного массива
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    //Конец константного массива
+    const_iterator end() const {
+        return const_iterator(this, m_size);
+    }
+
+    //Средний: О(n)
+    //Сжатая копия отсортированного целочисленного массива (VectorLegacyCompressed.h)
+    VectorLegacyCompressed<T> compress() const {
+        return VectorLegacyCompressed<T>(*this);
+    }
+
+    //Средний: О(1)
+    //Невладеющий срез из n элементов начиная с index. Память не выделяется, данные не копируются.
+    //Изменения через срез видны в массиве, поэтому массив перестает считаться отсортированным
+    //(до следующей сортировки). Срез получает текущую сортированность
+    VectorLegacyView<T> slice(size_t index, size_t n) {
+        if (index > m_size || n > m_size - index) {
+            throw out_of_range("Invalid index or count");
+        }
+        detach();
+        bool sorted = m_sorted;
+        m_sorted = false;
+        return VectorLegacyView<T>(m_data + index, n, sorted);
+    }
+
+    //Срез только для чтения. Перенос здесь не завершается, поэтому во время постепенного роста
+    //срез должен целиком лежать в одном буфере
+    VectorLegacyView<const T> slice(size_t index, size_t n) const {
+        if (index > m_size || n > m_size - index) {
+            throw out_of_range("Invalid index or count");
+        }
+        const T* first = nullptr;
+        size_t runs = 0;
+        for_runs(index, index + n, [&](const T* p, size_t) {
+            first = p;
+            ++runs;
+        });
+        if (runs > 1) {
+            throw runtime_error("Slice spans an unfinished migration");
+        }
+        return VectorLegacyView<const T>(n == 0 ? m_data + index : first, n, m_sorted);
+    }
+
     //iterator begin() {
     //    return iterator(data());
     //}
@@ -736,21 +2351,19 @@ public:
     //iterator end() {
     //    return iterator(data() + size());
     //}
-    //Быстрая сортировка
-    void sort_quick(size_t low, size_t high) {
-        // Если массив содержит более одного элемента
+    //Быстрая сортировка [low, high] (VectorLegacyKernels::sort_quick, общая со срезами)
+    template <typename Compare = less<T>>
+    void sort_quick(size_t low, size_t high, Compare comp = Compare()) {
+        detach();
         if (low < high) {
-            // Разбить массив вокруг опорного элемента
-            size_t pi = partition(low, high);
-
-            // Рекурсивно отсортировать левый и правый подмассивы
-            sort_quick(low, pi);
-            sort_quick(pi + 1, high);
+            VectorLegacyKernels::sort_quick(m_data, low, high, VectorLegacyKernels::depth_limit(high - low + 1), comp);
         }
-        m_sorted = true;
+        m_sorted = ascending(comp);
     }
-    //Слияние массивов
-    void merge(size_t left, size_t mid, size_t right) {
+    //Слияние массивов. Устойчиво: при равенстве первым идет элемент левой половины
+    template <typename Compare = less<T>>
+    void merge(size_t left, size_t mid, size_t right, Compare comp = Compare()) {
+        detach();
         // Проверка корректности индексов
         if (left > mid || mid > right) {
             throw std::out_of_range("Invalid indices");
@@ -759,13 +2372,15 @@ public:
         // Размер временного массива
         size_t temp_size = right - left + 1;
 
-        // Создание временного массива
-        VectorLegacy<T> temp(temp_size);
+        // Создание временного массива. Без заполнения нулем -- T может не строиться из 0
+        VectorLegacy<T> temp;
+        temp.reserve_for(temp_size);
+        temp.m_size = temp_size;
 
         // Копирование элементов из m_data в temp
         size_t i = left, j = mid + 1, k = 0;
         while (i <= mid && j <= right) {
-            if (m_data[i] <= m_data[j]) {
+            if (!comp(m_data[j], m_data[i])) {
                 temp[k++] = m_data[i++];
             }
             else {
@@ -790,33 +2405,333 @@ public:
     }
     //Все случаи O(n log(n))
     //Сортировка слиянеим
-    void sort_merge(size_t left, size_t right) {
+    template <typename Compare = less<T>>
+    void sort_merge(size_t left, size_t right, Compare comp = Compare()) {
+        detach();
         if (left < right) {
             size_t mid = (left + right) / 2;
-            sort_merge(left, mid);
-            sort_merge(mid + 1, right);
-            merge(left, mid, right);
+            sort_merge(left, mid, comp);
+            sort_merge(mid + 1, right, comp);
+            merge(left, mid, right, comp);
         }
-        m_sorted = true;
+        m_sorted = ascending(comp);
     }
-    //Сортировка по возрастанию. Если меньше миллиона значений, то быстрая, иначе слиянием
+    //Средний: О(n log(n)), Лучший: О(n)
+    //Сортировка по возрастанию. Уже упорядоченные серии не пересортировываются, поэтому почти
+    //отсортированный массив (дописанные по возрастанию пачки) сортируется почти за линейное время
     void sort()
     {
-        if (size() < 1000000)
-        {
-            sort_quick(0, size()-1);
+        sort_with(less<T>());
+        m_sorted = true;
+    }
+    //Сортировка по компаратору comp (строгий порядок "меньше"). comp встраивается при компиляции.
+    //Флаг сортированности ставится только для less<T>, иначе seek не сможет искать бинарно
+    template <typename Compare>
+    void sort(Compare comp)
+    {
+        sort_with(comp);
+        m_sorted = ascending(comp);
+    }
+    //Средний: О(n log(n)), Лучший: О(n)
+    //Устойчивая сортировка: равные элементы сохраняют взаимный порядок
+    template <typename Compare = less<T>>
+    void stable_sort(Compare comp = Compare())
+    {
+        sort_with(comp);
+        m_sorted = ascending(comp);
+    }
+    //Сортировка по ключу key(элемент), ключи сравниваются через operator<.
+    //cache_keys: ключ каждого элемента вычисляется один раз, сортируются пары (ключ, индекс),
+    //затем элементы переставляются по циклам. Стоит включать для дорогих ключей (строки, хеши).
+    //С кешем сортировка устойчива, так как равные ключи упорядочиваются по индексу
+    template <typename KeyFn>
+    void sort_by_key(KeyFn key, bool cache_keys = false)
+    {
+        typedef typename decay<decltype(key(declval<const T&>()))>::type Key;
+        if (!cache_keys) {
+            sort_with([&key](const T& a, const T& b) { return key(a) < key(b); });
+        }
+        else if (m_size > 1) {
+            detach();
+            VectorLegacy<pair<Key, size_t>> keys;
+            keys.reserve_for(m_size);
+            for (size_t i = 0; i < m_size; ++i) {
+                keys.m_data[i] = make_pair(key(m_data[i]), i);
+            }
+            keys.m_size = m_size;
+            keys.sort();
+            permute(keys);
         }
-        else
-        {
-            sort_merge(0, size()-1);
+        m_sorted = false;
+    }
+    //Средний: О(n), Худший: О(n log(n))
+    //Ставит на место k элемент, который стоял бы там после сортировки. Слева от него -- не большие,
+    //справа -- не меньшие. Интроселект: разбиения partition, а при слишком глубоком спуске
+    //(неудачные опорные элементы) -- выбор через кучу
+    template <typename Compare = less<T>>
+    void nth_element(size_t k, Compare comp = Compare()) {
+        if (k >= m_size) {
+            throw out_of_range("Invalid index");
+        }
+        // m_sorted не проверяется: после записи через [] он может быть устаревшим
+        detach();
+
+        size_t lo = 0;
+        size_t hi = m_size - 1;
+        // Допустимое число разбиений: 2 * log2(n)
+        size_t depth = 0;
+        for (size_t n = m_size; n > 1; n >>= 1) {
+            depth += 2;
+        }
+
+        while (lo < hi) {
+            if (depth-- == 0) {
+                // Куча из k - lo + 1 наименьших элементов [lo, hi], вершина -- искомый элемент
+                T* first = m_data + lo;
+                T* middle = m_data + k + 1;
+                make_heap(first, middle, comp);
+                for (T* p = middle; p != m_data + hi + 1; ++p) {
+                    if (comp(*p, *first)) {
+                        pop_heap(first, middle, comp);
+                        std::swap(*(middle - 1), *p);
+                        push_heap(first, middle, comp);
+                    }
+                }
+                std::swap(*first, m_data[k]);
+                break;
+            }
+            size_t pi = partition(lo, hi, comp);
+            if (pi == k) {
+                break;
+            }
+            if (k < pi) {
+                hi = pi - 1;
+            }
+            else {
+                lo = pi + 1;
+            }
+        }
+        m_sorted = false;
+    }
+    //Средний: О(n + k log(k))
+    //Сортирует только первые k позиций: там оказываются k наименьших элементов по порядку
+    template <typename Compare = less<T>>
+    void partial_sort(size_t k, Compare comp = Compare()) {
+        if (k > m_size) {
+            throw out_of_range("Invalid count");
+        }
+        if (k == 0) {
+            return;
+        }
+        nth_element(k - 1, comp);
+        // Пирамидальная сортировка: О(k log(k)) и при множестве равных ключей, на которых разбиение Ломуто вырождается
+        make_heap(m_data, m_data + k, comp);
+        sort_heap(m_data, m_data + k, comp);
+        m_sorted = k == m_size && ascending(comp);
+    }
+    //Средний: О(n log(k))
+    //Записывает в out k наибольших элементов по убыванию, массив не меняется.
+    //Один проход с кучей из k элементов, поэтому подходит для потоковой обработки
+    template <typename Compare = less<T>>
+    void top_k(size_t k, VectorLegacy<T>& out, Compare comp = Compare()) const {
+        k = min(k, m_size);
+        out.m_size = 0;
+        out.reserve_for(k);
+        out.detach();
+        // Вершина кучи -- наименьший из отобранных
+        auto heap_comp = [&comp](const T& a, const T& b) { return comp(b, a); };
+        T* heap = out.m_data;
+        for (size_t i = 0; i < m_size; ++i) {
+            if (out.m_size < k) {
+                heap[out.m_size++] = element(i);
+                push_heap(heap, heap + out.m_size, heap_comp);
+            }
+            else if (k != 0 && comp(heap[0], element(i))) {
+                pop_heap(heap, heap + k, heap_comp);
+                heap[k - 1] = element(i);
+                push_heap(heap, heap + k, heap_comp);
+            }
+        }
+        sort_heap(heap, heap + out.m_size, heap_comp);
+        out.m_sorted = out.m_size == 1;
+    }
+//----------------------------------------------------------------Операции над множествами--------------------------------------------------
+    //Средний: О(n)
+    //Удаляет подряд идущие повторы, порядок сохраняется. У отсортированного массива остаются различные значения
+    void unique() {
+        if (m_size < 2) {
+            return;
+        }
+        detach();
+        size_t count = 1;
+        for (size_t i = 1; i < m_size; ++i) {
+            if (!(m_data[i] == m_data[count - 1])) {
+                if (count != i) {
+                    m_data[count] = std::move(m_data[i]);
+                }
+                ++count;
+            }
+        }
+        m_size = count;
+    }
+    //Средний: О(n + m) для отсортированных, О(m log(n)) при m << n. Иначе добавляется сортировка копий
+    //Объединение. Результат отсортирован
+    VectorLegacy set_union(const VectorLegacy& other) const {
+        return set_sweep(other, true, true, true);
+    }
+    //Пересечение. Результат отсортирован
+    VectorLegacy set_intersection(const VectorLegacy& other) const {
+        return set_sweep(other, false, true, false);
+    }
+    //Разность: элементы this, которых нет в other. Результат отсортирован
+    VectorLegacy set_difference(const VectorLegacy& other) const {
+        return set_sweep(other, true, false, false);
+    }
+    //Средний: О(n log(k)), при перекосе входов меньше: длинные серии одного входа переносятся галопом
+    //Слияние k отсортированных массивов inputs[0], ..., inputs[k - 1] в один, память результата выделяется один раз.
+    //Устойчиво: равные элементы идут в порядке номеров входов. Неотсортированные входы сортируются в копиях
+    template <typename Compare = less<T>>
+    static VectorLegacy merge_sorted(const VectorLegacy* inputs, size_t k, Compare comp = Compare()) {
+        return merge_all(inputs, k, comp, false);
+    }
+
+    template <typename Compare = less<T>>
+    static VectorLegacy merge_sorted(const VectorLegacy<VectorLegacy>& inputs, Compare comp = Compare()) {
+        VectorLegacy<VectorLegacy> scratch;
+        return merge_all(inputs.contiguous(scratch), inputs.size(), comp, false);
+    }
+//----------------------------------------------------------------Параллельные операции--------------------------------------------------
+    //Средний: О(n/p)
+    //Вызывает f(элемент) для каждого элемента. Порядок вызовов не определен
+    template <typename F>
+    void parallel_for_each(F f) {
+        detach();
+        if (m_size < parallel_grain()) {
+            for (T* p = m_data, *last = m_data + m_size; p != last; ++p) {
+                f(*p);
+            }
+        }
+        else {
+            T* data = m_data;
+            for_chunks([&](size_t lo, size_t hi, size_t) {
+                for (size_t i = lo; i < hi; ++i) {
+                    f(data[i]);
+                }
+            });
+        }
+        m_sorted = false;
+    }
+
+    //Средний: О(n/p)
+    //Заменяет каждый элемент на f(элемент)
+    template <typename F>
+    void parallel_transform(F f) {
+        detach();
+        if (m_size < parallel_grain()) {
+            for (T* p = m_data, *last = m_data + m_size; p != last; ++p) {
+                *p = f(*p);
+            }
+        }
+        else {
+            T* data = m_data;
+            for_chunks([&](size_t lo, size_t hi, size_t) {
+                for (size_t i = lo; i < hi; ++i) {
+                    data[i] = f(data[i]);
+                }
+            });
+        }
+        m_sorted = false;
+    }
+
+    //Средний: О(n/p)
+    //Заполняет массив значением value
+    void parallel_fill(const T& value) {
+        detach();
+        if (m_size < parallel_grain()) {
+            fill(m_data, m_data + m_size, value);
+        }
+        else {
+            T* data = m_data;
+            for_chunks([&](size_t lo, size_t hi, size_t) {
+                fill(data + lo, data + hi, value);
+            });
         }
         m_sorted = true;
     }
 
+    //Средний: О(n/p + p)
+    //Свертка init op a[0] op a[1] ... op a[n-1]. op должна быть ассоциативной.
+    //deterministic: частичные результаты кусков объединяются по порядку кусков, поэтому
+    //результат (в том числе для чисел с плавающей точкой) одинаков при любом числе потоков.
+    //Иначе каждый поток копит свой результат, и порядок объединения зависит от расписания
+    template <typename Op>
+    T parallel_reduce(const T& init, Op op, bool deterministic = false) const {
+        T result = init;
+        if (m_size < parallel_grain()) {
+            for_runs(0, m_size, [&](const T* p, size_t n) {
+                for (const T* last = p + n; p != last; ++p) {
+                    result = op(result, *p);
+                }
+            });
+            return result;
+        }
+
+        // Частичный результат куска начинается с его первого элемента, нейтральный элемент не нужен
+        auto reduce_chunk = [&](size_t lo, size_t hi) {
+            T partial = element(lo);
+            for_runs(lo + 1, hi, [&](const T* p, size_t n) {
+                for (const T* last = p + n; p != last; ++p) {
+                    partial = op(partial, *p);
+                }
+            });
+            return partial;
+        };
+
+        if (deterministic) {
+            vector<T> partials(parallel_chunks(m_size));
+            for_chunks([&](size_t lo, size_t hi, size_t) {
+                partials[lo / parallel_chunk()] = reduce_chunk(lo, hi);
+            });
+            for (size_t i = 0; i < partials.size(); ++i) {
+                result = op(result, partials[i]);
+            }
+        }
+        else {
+            vector<T> partials(ThreadPool::instance().size());
+            vector<char> used(partials.size(), 0);
+            for_chunks([&](size_t lo, size_t hi, size_t worker) {
+                T partial = reduce_chunk(lo, hi);
+                partials[worker] = used[worker] ? op(partials[worker], partial) : partial;
+                used[worker] = 1;
+            });
+            for (size_t i = 0; i < partials.size(); ++i) {
+                if (used[i]) {
+                    result = op(result, partials[i]);
+                }
+            }
+        }
+        return result;
+    }
+
+    //Средний: О(n log(k) / p + p k^2 log^2(n))
+    //Параллельное слияние k отсортированных массивов. Результат делится на куски поиском разделителей
+    //по рангу, куски сливаются в пуле потоков. Результат совпадает с merge_sorted
+    template <typename Compare = less<T>>
+    static VectorLegacy parallel_merge_sorted(const VectorLegacy* inputs, size_t k, Compare comp = Compare()) {
+        return merge_all(inputs, k, comp, true);
+    }
 
+    template <typename Compare = less<T>>
+    static VectorLegacy parallel_merge_sorted(const VectorLegacy<VectorLegacy>& inputs, Compare comp = Compare()) {
+        VectorLegacy<VectorLegacy> scratch;
+        return merge_all(inputs.contiguous(scratch), inputs.size(), comp, true);
+    }
 
 };
 
+// Битовая специализация VectorLegacy<bool>
+#include "VectorLegacyBool.h"
+
 //Процедура тестирования
 void test() {
     // Тестирование конструкторов
@@ -883,6 +2798,7 @@ void test() {
     assert(v1.size() == 6);
     assert(v1.capacity() == 10);
     assert(v1[0] == 0);
+    assert(v1[1] == 1);
 
     // Тестирование метода pop_front
     v1.pop_front();
@@ -895,6 +2811,7 @@ void test() {
     assert(v1.size() == 6);
     assert(v1.capacity() == 10);
     assert(v1[2] == 10);
+    assert(v1[3] == 3);
 
     // Тестирование метода insert (массив)
     int arr[] = { 11, 12, 13 };
@@ -983,5 +2900,501 @@ void test() {
     v1.print();
     assert(v1 == VectorLegacy<int>({ 1, 2, 3, 4, 5 }));
 
+    // Тестирование больших буферов (на Linux выделяются через mmap и растут через mremap).
+    // Размер чуть больше порога map_threshold() (4 МБ), большие объемы -- в VectorBenchmark.h
+    size_t big_n = (4u << 20) / sizeof(double) + 1024;
+    VectorLegacy<double> big(big_n, 1.5);
+    big[big_n - 1] = 2.5;
+    VectorLegacy<double> grown(big);
+    assert(grown.capacity() == big_n);
+    grown.push_back(3.5);
+    assert(grown.size() == big_n + 1);
+    assert(grown.capacity() > big_n);
+    assert(grown[0] == 1.5);
+    assert(grown[big_n - 1] == 2.5);
+    assert(grown[big_n] == 3.5);
+    // Уменьшение ниже порога переносит данные обратно в обычный буфер
+    while (grown.size() > 1000) {
+        grown.pop_back();
+    }
+    assert(grown.capacity() < big_n);
+    assert(grown[0] == 1.5);
+    assert(grown[999] == 1.5);
+
+    // Тестирование параллельных операций
+    VectorLegacy<int> par(100000, 1);
+    par.parallel_fill(2);
+    assert(par.sorted());
+    par.parallel_transform([](int x) { return x * 3; });
+    assert(par[0] == 6 && par[99999] == 6);
+    par.parallel_for_each([](int& x) { x -= 5; });
+    assert(par.parallel_reduce(0, [](int a, int b) { return a + b; }) == 100000);
+    assert(par.parallel_reduce(0, [](int a, int b) { return a + b; }, true) == 100000);
+    par[777] = 42;
+    assert(par.parallel_reduce(0, [](int a, int b) { return max(a, b); }) == 42);
+    // Маленький массив обрабатывается последовательно
+    v1 = { 1, 2, 3, 4 };
+    v1.parallel_transform([](int x) { return x * x; });
+    assert(v1 == VectorLegacy<int>({ 1, 4, 9, 16 }));
+    assert(v1.parallel_reduce(1, [](int a, int b) { return a * b; }) == 576);
+
+    // Тестирование конструктора из диапазона, append и assign
+    list<int> range = { 1, 2, 3 };
+    VectorLegacy<int> ranged(range.begin(), range.end());
+    assert(ranged.size() == 3 && ranged.capacity() == 3);
+    assert(ranged.sorted());
+    VectorLegacy<int> tail({ 4, 5 });
+    ranged.append(tail);
+    assert(ranged == VectorLegacy<int>({ 1, 2, 3, 4, 5 }));
+    assert(ranged.sorted());
+    ranged.append(ranged);
+    assert(ranged.size() == 10 && ranged[5] == 1 && ranged[9] == 5);
+    assert(!ranged.sorted());
+    int more[] = { 7, 8 };
+    ranged.append(more, more + 2);
+    assert(ranged.size() == 12 && ranged[11] == 8);
+    stringstream input("9 8 7 6");
+    ranged.assign(istream_iterator<int>(input), istream_iterator<int>());
+    assert(ranged == VectorLegacy<int>({ 9, 8, 7, 6 }));
+    assert(ranged.capacity() >= 12);
+    ranged.assign(range.begin(), range.end());
+    assert(ranged == VectorLegacy<int>({ 1, 2, 3 }));
+    assert(ranged.sorted());
+    // Диапазоны из move_iterator и append(VectorLegacy&&) перемещают элементы: исходные shared_ptr пустеют
+    shared_ptr<int> owned[3] = { make_shared<int>(0), make_shared<int>(1), make_shared<int>(2) };
+    VectorLegacy<shared_ptr<int>> owners(make_move_iterator(owned), make_move_iterator(owned + 3));
+    assert(!owned[0] && *owners[2] == 2 && owners[0].use_count() == 1);
+    shared_ptr<int> more_owned[2] = { make_shared<int>(3), make_shared<int>(4) };
+    owners.append(make_move_iterator(more_owned), make_move_iterator(more_owned + 2));
+    assert(!more_owned[1] && owners.size() == 5 && owners[0].use_count() == 1 && owners[4].use_count() == 1);
+    VectorLegacy<shared_ptr<int>> donor;
+    donor.push_back(make_shared<int>(5));
+    owners.append(std::move(donor));
+    assert(donor.size() == 0 && *owners[5] == 5 && owners[5].use_count() == 1);
+    owners.assign(make_move_iterator(owned), make_move_iterator(owned + 3));
+    assert(owners.size() == 3 && !owners[0]);
+
+    // Тестирование сортировки с компаратором и по ключу
+    v1 = { 5, 3, 1, 2, 4 };
+    v1.sort(greater<int>());
+    assert(v1 == VectorLegacy<int>({ 5, 4, 3, 2, 1 }));
+    assert(!v1.sorted());
+    v1.sort(less<int>());
+    assert(v1 == VectorLegacy<int>({ 1, 2, 3, 4, 5 }));
+    assert(v1.sorted());
+    VectorLegacy<pair<string, int>> records;
+    records.push_back(make_pair(string("b"), 1));
+    records.push_back(make_pair(string("a"), 2));
+    records.push_back(make_pair(string("b"), 3));
+    records.push_back(make_pair(string("a"), 4));
+    VectorLegacy<pair<string, int>> cached(records);
+    records.stable_sort([](const pair<string, int>& a, const pair<string, int>& b) { return a.first < b.first; });
+    assert(records[0].second == 2 && records[1].second == 4 && records[2].second == 1 && records[3].second == 3);
+    cached.sort_by_key([](const pair<string, int>& r) { return r.first; }, true);
+    for (size_t i = 0; i < cached.size(); ++i) {
+        assert(cached[i] == records[i]);
+    }
+    records.sort_by_key([](const pair<string, int>& r) { return -r.second; });
+    assert(records[0].second == 4 && records[3].second == 1);
+
+    // Тестирование постепенного роста: чтение и запись во время переноса
+    VectorLegacy<int> gradual;
+    gradual.enable_incremental_growth(3);
+    for (int i = 0; i < 1000; ++i) {
+        gradual.push_back(i);
+        const VectorLegacy<int>& view = gradual;
+        assert(view[i / 2] == i / 2 && gradual.back() == i);
+    }
+    gradual[10] = -10;
+    assert(gradual.pop_back() == 999 && gradual.at(10) == -10);
+    gradual[10] = 10;
+    assert(gradual.seek_sequentional(500) == 500);
+    assert(gradual.size() == 999 && gradual.incremental_growth() == 3);
+    for (int i = 0; i < 999; ++i) {
+        assert(gradual[i] == i);
+    }
+    // Константные операции читают оба буфера, не продвигая перенос
+    VectorLegacy<int> moving;
+    moving.enable_incremental_growth(3);
+    for (int i = 0; i < 1025; ++i) {
+        moving.push_back(i);
+    }
+    const VectorLegacy<int>& frozen = moving;
+    long long frozen_sum = 0;
+    for (int x : frozen) {
+        frozen_sum += x;
+    }
+    VectorLegacy<int> moving_copy(frozen);
+    assert(frozen_sum == 524800 && moving_copy == frozen && frozen.parallel_reduce(0, plus<int>()) == 524800);
+    assert(frozen.seek_sequentional(1000) == 1000 && is_sorted(frozen.begin(), frozen.end()));
+
+    // Тестирование хеш-индекса: позиция первого вхождения при поддержке на месте и перестройке
+    VectorLegacy<int> hashed({ 7, 3, 7, 9 });
+    hashed.enable_index();
+    assert(hashed.indexed() && hashed.seek(7) == 0 && hashed.seek(9) == 3 && hashed.seek(4) == 4);
+    hashed.push_back(4);
+    hashed.swap(0, 1);
+    assert(hashed.seek(4) == 4 && hashed.seek(7) == 1 && hashed.seek(3) == 0);
+    hashed.pop_front();
+    hashed.delete_(0);
+    assert(hashed.seek(7) == 0 && hashed.seek(3) == 3);
+    hashed.insert(0, 9);
+    hashed[3] = 5;
+    assert(hashed.seek(9) == 0 && hashed.seek(5) == 3 && hashed.seek(4) == 4);
+    assert(hashed.pop_back() == 5 && hashed.seek(5) == 3);
+    VectorLegacy<int> rewired({ 3, 1, 2, 7 });
+    rewired.enable_index();
+    assert(rewired.seek(7) == 3);
+    rewired[3] = 100;
+    assert(rewired.seek(100) == 3 && rewired.seek(7) == 4);
+    rewired.at(0) = 8;
+    rewired.back() = 9;
+    assert(rewired.seek(8) == 0 && rewired.seek(9) == 3 && rewired.seek(3) == 4);
+    VectorLegacy<string> names({ "b", "a", "b" });
+    names.enable_index();
+    assert(names.seek("b") == 0 && names.seek("c") == 3);
+    hashed.disable_index();
+    assert(!hashed.indexed() && hashed.seek(9) == 0);
+
+    // Запись через [] не сбрасывает флаг сортированности, но sort все равно сортирует
+    VectorLegacy<int> rewritten({ 1, 2, 3, 4, 5 });
+    rewritten.sort();
+    rewritten[0] = 9;
+    rewritten.sort();
+    assert(rewritten == VectorLegacy<int>({ 2, 3, 4, 5, 9 }) && rewritten.sorted());
+    VectorLegacy<int> flat(5, 0);
+    flat[2] = -1;
+    flat.sort();
+    assert(flat[0] == -1 && flat[2] == 0);
+
+    // Тестирование адаптивной сортировки: серии по возрастанию, убывающие хвосты, повторы
+    VectorLegacy<int> batches;
+    for (int batch = 0; batch < 20; ++batch) {
+        for (int i = 0; i < 300; ++i) {
+            batches.push_back(batch % 2 == 0 ? batch * 100 + i : 5000 - i % 50);
+        }
+    }
+    VectorLegacy<int> expected(batches);
+    expected.sort_quick(0, expected.size() - 1);
+    batches.sort();
+    assert(batches == expected && batches.sorted());
+    // Отсортированный массив: одна серия, сравнений не больше n
+    size_t comparisons = 0;
+    batches.sort([&comparisons](int a, int b) { ++comparisons; return a < b; });
+    assert(comparisons < batches.size());
+    VectorLegacy<pair<int, int>> keyed;
+    for (int i = 0; i < 2000; ++i) {
+        keyed.push_back(make_pair((i * 7919) % 13, i));
+    }
+    keyed.stable_sort([](const pair<int, int>& a, const pair<int, int>& b) { return a.first < b.first; });
+    for (size_t i = 1; i < keyed.size(); ++i) {
+        assert(keyed[i - 1].first < keyed[i].first || (keyed[i - 1].first == keyed[i].first && keyed[i - 1].second < keyed[i].second));
+    }
+
+    // Тестирование частичной сортировки и выбора
+    v1 = { 9, 1, 8, 2, 7, 3, 6, 4, 5, 0 };
+    v1.nth_element(4);
+    assert(v1[4] == 4);
+    for (size_t i = 0; i < 4; ++i) {
+        assert(v1[i] < 4);
+    }
+    for (size_t i = 5; i < v1.size(); ++i) {
+        assert(v1[i] > 4);
+    }
+    v1 = { 9, 1, 8, 2, 7, 3, 6, 4, 5, 0 };
+    v1.partial_sort(3);
+    assert(v1[0] == 0 && v1[1] == 1 && v1[2] == 2);
+    assert(!v1.sorted());
+    // Устаревший флаг сортированности не отменяет выбор
+    VectorLegacy<int> stale({ 1, 2, 3, 4, 5 });
+    stale[0] = 9;
+    stale.nth_element(4);
+    assert(stale[4] == 9);
+    stale = { 1, 2, 3, 4, 5 };
+    stale[0] = 9;
+    stale.partial_sort(2);
+    assert(stale[0] == 2 && stale[1] == 3);
+    // Много равных ключей: первые k позиций по порядку
+    VectorLegacy<int> repeated;
+    for (int i = 0; i < 100000; ++i) {
+        repeated.push_back((i * 7) % 3);
+    }
+    repeated.partial_sort(50000);
+    for (size_t i = 1; i < 50000; ++i) {
+        assert(repeated[i - 1] <= repeated[i]);
+    }
+    assert(repeated[33333] == 0 && repeated[33334] == 1 && repeated[49999] == 1);
+    VectorLegacy<int> top;
+    v1.top_k(3, top);
+    assert(top == VectorLegacy<int>({ 9, 8, 7 }));
+    v1.top_k(20, top);
+    assert(top.size() == 10 && top[0] == 9 && top[9] == 0);
+    // Много равных элементов: срабатывает запасной выбор через кучу
+    VectorLegacy<int> same(1000, 7);
+    same[500] = 1;
+    same.push_back(9);
+    same.nth_element(0);
+    assert(same[0] == 1);
+    same.nth_element(1000);
+    assert(same[1000] == 9);
+
+    // Тестирование операций над множествами
+    v1 = { 1, 1, 2, 3, 3, 3, 5 };
+    v1.unique();
+    assert(v1 == VectorLegacy<int>({ 1, 2, 3, 5 }));
+    assert(v1.sorted());
+    VectorLegacy<int> other({ 5, 2, 4 });
+    assert(v1.set_union(other) == VectorLegacy<int>({ 1, 2, 3, 4, 5 }));
+    assert(v1.set_intersection(other) == VectorLegacy<int>({ 2, 5 }));
+    assert(v1.set_difference(other) == VectorLegacy<int>({ 1, 3 }));
+    assert(v1.set_union(other).sorted());
+    assert(other == VectorLegacy<int>({ 5, 2, 4 }));
+    // Сильно разные размеры: галоп
+    VectorLegacy<int> wide;
+    for (int i = 0; i < 1000; ++i) {
+        wide.push_back(i * 2);
+    }
+    wide.sort();
+    VectorLegacy<int> narrow({ 3, 500, 1998, 2001 });
+    assert(wide.set_intersection(narrow) == VectorLegacy<int>({ 500, 1998 }));
+    assert(narrow.set_difference(wide) == VectorLegacy<int>({ 3, 2001 }));
+    VectorLegacy<int> joined = wide.set_union(narrow);
+    assert(joined.size() == 1002 && joined[2] == 3 && joined[1001] == 2001);
+    assert(joined.seek(2001) == 1001);
+
+    // Тестирование копирования при записи
+    VectorLegacy<int> origin({ 1, 2, 3 });
+    origin.enable_cow();
+    VectorLegacy<int> snapshot(origin);
+    assert(snapshot.cow());
+    assert(snapshot.begin() == origin.begin());
+    origin.push_back(4);
+    assert(snapshot.begin() != origin.begin());
+    assert(snapshot == VectorLegacy<int>({ 1, 2, 3 }));
+    assert(origin == VectorLegacy<int>({ 1, 2, 3, 4 }));
+    VectorLegacy<int> second;
+    second = origin;
+    second[0] = 10;
+    assert(origin[0] == 1 && second[0] == 10);
+    // Снимок читается в другом потоке, пока исходный массив меняется
+    snapshot = origin;
+    thread reader([snapshot]() {
+        assert(snapshot.parallel_reduce(0, [](int a, int b) { return a + b; }) == 10);
+    });
+    origin.sort(greater<int>());
+    reader.join();
+    assert(origin[0] == 4 && snapshot[0] == 1);
+    origin.disable_cow();
+    VectorLegacy<int> deep(origin);
+    assert(!deep.cow() && deep.begin() != origin.begin());
+
+    // Тестирование срезов
+    v1 = { 9, 1, 8, 2, 7, 3, 6, 4, 5, 0 };
+    VectorLegacyView<int> head = v1.slice(0, 5);
+    assert(head.size() == 5 && !head.sorted());
+    assert(head.seek(7) == 4 && head.seek(0) == 5);
+    assert(head.count(1) == 1);
+    head.sort();
+    assert(head.sorted());
+    assert(v1 == VectorLegacy<int>({ 1, 2, 7, 8, 9, 3, 6, 4, 5, 0 }));
+    assert(head.seek(8) == 3 && head.seek_interpol(1) == 0 && head.seek(5) == 5);
+    assert(head.lower_bound(3) == 2);
+    int sliced_sum = 0;
+    for (int x : v1.slice(5, 5)) {
+        sliced_sum += x;
+    }
+    assert(sliced_sum == 18);
+    VectorLegacy<int> many(1000, 3);
+    const VectorLegacy<int>& readonly = many;
+    VectorLegacyView<const int> tail_view = readonly.slice(100, 900);
+    assert(tail_view.sorted() && tail_view.count(3) == 900 && tail_view.seek(3) < 900);
+    assert(tail_view.slice(10, 10).size() == 10);
+    VectorLegacy<int> shuffled;
+    for (int i = 0; i < 1000; ++i) {
+        shuffled.push_back((i * 7919) % 1000);
+    }
+    VectorLegacyView<int> whole = shuffled.slice(0, 1000);
+    whole.sort();
+    for (int i = 0; i < 1000; ++i) {
+        assert(whole[i] == i);
+    }
+    // Запись через срез сбрасывает сортированность массива: поиск идет по фактическим данным
+    VectorLegacy<int> rising({ 1, 2, 3, 4, 5, 6 });
+    VectorLegacyView<int> rising_tail = rising.slice(3, 3);
+    assert(rising_tail.sorted() && !rising.sorted());
+    rising_tail[0] = 0;
+    assert(rising.seek(0) == 3 && rising.seek(4) == 6);
+    // Срез строк: отсортированный срез ищет бинарным поиском
+    VectorLegacy<string> callsigns({ "delta", "alpha", "echo", "bravo" });
+    VectorLegacyView<string> word_view = callsigns.slice(0, 4);
+    word_view.sort();
+    assert(word_view.seek("bravo") == 1 && word_view.seek("echo") == 3 && word_view.seek("zulu") == 4);
+
+    // Заполнение и копирование: memset, потоковые записи, параллельные куски.
+    // Размер чуть больше copy_threshold() (1 МБ), большие объемы -- в VectorBenchmark.h
+    VectorLegacy<char> letters(100, 'x');
+    assert(letters.size() == 100 && letters[0] == 'x' && letters[99] == 'x');
+    size_t filled_n = (1u << 20) / sizeof(long long) + 3;
+    VectorLegacy<long long> filled(filled_n, 0x0102030405060708LL);
+    assert(filled[0] == 0x0102030405060708LL && filled[filled_n / 2] == 0x0102030405060708LL);
+    assert(filled[filled_n - 1] == 0x0102030405060708LL);
+    VectorLegacy<long long> zeros(filled_n, 0);
+    assert(zeros[0] == 0 && zeros[filled_n - 1] == 0);
+    filled[filled_n - 2] = 5;
+    VectorLegacy<long long> filled_copy(filled);
+    assert(filled_copy.size() == filled_n && filled_copy[filled_n - 2] == 5 && filled_copy[filled_n - 1] == 0x0102030405060708LL);
+    zeros = filled;
+    assert(zeros == filled);
+
+    // Очистка: вместимость сохраняется, строки освобождаются, разделенный буфер не портится
+    VectorLegacy<string> words({ "alpha", "beta", "gamma" });
+    words.clear();
+    assert(words.size() == 0 && words.capacity() == 3);
+    words.push_back("delta");
+    assert(words[0] == "delta");
+    VectorLegacy<int> shared_source({ 1, 2, 3 });
+    shared_source.enable_cow();
+    VectorLegacy<int> shared_copy(shared_source);
+    shared_copy.clear();
+    assert(shared_copy.size() == 0 && shared_copy.capacity() == 3);
+    assert(shared_source == VectorLegacy<int>({ 1, 2, 3 }));
+
+    // Слияние многих отсортированных массивов
+    VectorLegacy<VectorLegacy<int>> shards;
+    shards.push_back(VectorLegacy<int>({ 1, 4, 7 }));
+    shards.push_back(VectorLegacy<int>({ 2, 5, 8 }));
+    shards.push_back(VectorLegacy<int>());
+    shards.push_back(VectorLegacy<int>({ 9, 3, 6 }));
+    VectorLegacy<int> merged_shards = VectorLegacy<int>::merge_sorted(shards);
+    assert(merged_shards == VectorLegacy<int>({ 1, 2, 3, 4, 5, 6, 7, 8, 9 }));
+    assert(merged_shards.sorted() && merged_shards.capacity() == 9);
+    VectorLegacy<int> descending = VectorLegacy<int>::merge_sorted(shards.begin(), 2, greater<int>());
+    assert(descending == VectorLegacy<int>({ 8, 7, 5, 4, 2, 1 }) && !descending.sorted());
+    assert(VectorLegacy<int>::merge_sorted(shards.begin(), 0).size() == 0);
+    // Вход, переписанный через [], сортируется перед слиянием
+    VectorLegacy<int> rewritten_shards[2] = { VectorLegacy<int>({ 1, 2, 3 }), VectorLegacy<int>({ 4 }) };
+    rewritten_shards[0][0] = 9;
+    assert(VectorLegacy<int>::merge_sorted(rewritten_shards, 2) == VectorLegacy<int>({ 2, 3, 4, 9 }));
+    // Перекос: длинная серия одного входа переносится галопом, равные идут в порядке входов
+    VectorLegacy<pair<int, int>> skewed[3];
+    for (int i = 0; i < 1000; ++i) {
+        skewed[0].push_back(make_pair(i, 0));
+    }
+    skewed[1].push_back(make_pair(500, 1));
+    skewed[2].push_back(make_pair(500, 2));
+    skewed[2].push_back(make_pair(2000, 2));
+    auto by_key = [](const pair<int, int>& a, const pair<int, int>& b) { return a.first < b.first; };
+    VectorLegacy<pair<int, int>> merged_skewed = VectorLegacy<pair<int, int>>::merge_sorted(skewed, 3, by_key);
+    assert(merged_skewed.size() == 1003);
+    assert(merged_skewed[500] == make_pair(500, 0) && merged_skewed[501] == make_pair(500, 1));
+    assert(merged_skewed[502] == make_pair(500, 2) && merged_skewed[1002] == make_pair(2000, 2));
+    assert(is_sorted(merged_skewed.begin(), merged_skewed.end(), by_key));
+    // Параллельное слияние совпадает с последовательным
+    VectorLegacy<VectorLegacy<int>> many_shards;
+    srand(7);
+    for (int s = 0; s < 8; ++s) {
+        VectorLegacy<int> shard;
+        for (int i = 0; i < 20000; ++i) {
+            shard.push_back(rand() % (s == 3 ? 10 : 100000));
+        }
+        shard.sort();
+        many_shards.push_back(shard);
+    }
+    VectorLegacy<int> merged_many = VectorLegacy<int>::merge_sorted(many_shards);
+    assert(merged_many.size() == 160000 && is_sorted(merged_many.begin(), merged_many.end()));
+    assert(VectorLegacy<int>::parallel_merge_sorted(many_shards) == merged_many);
+
+    // Выравнивание буфера: сохраняется при росте, перемещении и копировании
+    auto aligned_to = [](const void* p, size_t alignment) { return reinterpret_cast<uintptr_t>(p) % alignment == 0; };
+    VectorLegacy<double> lanes({ 1.5, 2.5 });
+    lanes.set_alignment(32);
+    assert(lanes.alignment() == 64 && aligned_to(lanes.begin(), 64) && lanes[1] == 2.5);
+    for (int i = 0; i < 1000; ++i) {
+        lanes.push_back(i);
+        assert(aligned_to(lanes.begin(), 64));
+    }
+    VectorLegacy<double> lanes_copy(lanes);
+    assert(lanes_copy.alignment() == 64 && aligned_to(lanes_copy.begin(), 64) && lanes_copy == lanes);
+    VectorLegacy<double> lanes_moved(std::move(lanes_copy));
+    assert(lanes_moved.alignment() == 64 && aligned_to(lanes_moved.begin(), 64) && lanes_moved.size() == 1002);
+    lanes_moved.set_alignment(0);
+    assert(lanes_moved.alignment() == 0 && lanes_moved == lanes);
+    bool misaligned = false;
+    try {
+        lanes.set_alignment(48);
+    }
+    catch (const invalid_argument&) {
+        misaligned = true;
+    }
+    assert(misaligned && lanes.alignment() == 64);
+    VectorLegacy<string> aligned_words({ "x", "y" });
+    aligned_words.set_alignment(128);
+    for (int i = 0; i < 100; ++i) {
+        aligned_words.push_back(to_string(i));
+    }
+    assert(aligned_to(aligned_words.begin(), 128) && aligned_words[1] == "y" && aligned_words[101] == "99");
+    // Отображенный буфер с выравниванием больше страницы растет через mremap на заранее выровненное место.
+    // Размеры чуть больше map_threshold() (4 МБ): рост с 4 до 8 МБ идет между отображенными буферами
+    int mapped_n = (1 << 20) + 1024;
+    VectorLegacy<int> wide_aligned;
+    wide_aligned.set_alignment(1 << 16);
+    for (int i = 0; i < mapped_n; ++i) {
+        wide_aligned.push_back(i);
+    }
+    assert(aligned_to(wide_aligned.begin(), 1 << 16) && wide_aligned[mapped_n - 1] == mapped_n - 1);
+
+    // Большие страницы: буфер выровнен по 2 МБ и сохраняет данные при росте и смене режима
+    VectorLegacy<int> huge;
+    for (int i = 0; i < (1 << 20); ++i) {
+        huge.push_back(i);
+    }
+    huge.enable_huge_pages();
+    assert(huge.huge_pages() && huge[12345] == 12345);
+    for (int i = 1 << 20; i < mapped_n; ++i) {
+        huge.push_back(i);
+    }
+#ifdef __linux__
+    assert(aligned_to(huge.begin(), 2 * 1024 * 1024));
+#endif
+    VectorLegacy<int> huge_copy(huge);
+    assert(huge_copy.huge_pages() && huge_copy == huge);
+    huge.disable_huge_pages();
+    assert(!huge.huge_pages() && huge[mapped_n - 1] == mapped_n - 1);
+
+    // Удаление многих элементов за один проход
+    VectorLegacy<int> pruned({ 5, 1, 4, 1, 3, 1, 2, 9, 1 });
+    assert(pruned.erase_value(1) == 4);
+    assert(pruned == VectorLegacy<int>({ 5, 4, 3, 2, 9 }) && pruned.erase_value(7) == 0);
+    assert(pruned.remove_if([](int x) { return x % 2 == 0; }) == 2);
+    assert(pruned == VectorLegacy<int>({ 5, 3, 9 }));
+    VectorLegacy<int> ordered({ 1, 2, 2, 2, 3, 4, 4, 5, 6, 7 });
+    assert(ordered.sorted() && ordered.erase_value(2) == 3 && ordered.erase_value(4) == 2);
+    assert(ordered == VectorLegacy<int>({ 1, 3, 5, 6, 7 }) && ordered.sorted());
+    assert(ordered.erase_indices({ 0, 2, 2, 4 }) == 3);
+    assert(ordered == VectorLegacy<int>({ 3, 6 }) && ordered.sorted());
+    assert(ordered.remove_if([](int x) { return x > 4; }) == 1 && ordered.sorted() && ordered.size() == 1);
+    bool bad_indices = false;
+    try {
+        pruned.erase_indices({ 2, 1 });
+    }
+    catch (const invalid_argument&) {
+        bad_indices = true;
+    }
+    assert(bad_indices && pruned.size() == 3);
+    bad_indices = false;
+    try {
+        pruned.erase_indices({ 0, 3 });
+    }
+    catch (const out_of_range&) {
+        bad_indices = true;
+    }
+    assert(bad_indices && pruned.size() == 3);
+    VectorLegacy<float> readings({ 0.5f, -0.0f, 2.0f, 0.0f, 0.5f, 3.0f, 0.0f, 1.0f, 0.0f });
+    assert(readings.erase_value(0.0f) == 4 && readings == VectorLegacy<float>({ 0.5f, 2.0f, 0.5f, 3.0f, 1.0f }));
+    VectorLegacy<string> tags({ "keep", "drop", "keep", "drop" });
+    assert(tags.erase_value("drop") == 2 && tags == VectorLegacy<string>({ "keep", "keep" }));
+    tags.enable_index();
+    assert(tags.seek("keep") == 0 && tags.erase_indices({ 0 }) == 1 && tags.seek("keep") == 0);
+
     cout << "All tests passed!" << endl;
 }
\ No newline at end of file
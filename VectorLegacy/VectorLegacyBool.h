@@ -0,0 +1,692 @@
+#pragma once
+#include "VectorLegacy.h"
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+/*
+Битовый VectorLegacy<bool>: 64 флага в одном слове вместо байта на флаг.
+Слова хранятся в VectorLegacy<uint64_t>, поэтому рост и большие буферы работают так же,
+как у обычного массива. Биты последнего слова за пределами size() всегда нулевые --
+на этом держатся count(), find_first() и сравнение.
+Элемент по неконстантному [] -- прокси-объект reference, через него можно присваивать.
+*/
+template <>
+class VectorLegacy<bool> {
+private:
+    // Количество флагов
+    size_t m_size;
+    // Слова с флагами, флаг i -- бит i % 64 слова i / 64
+    VectorLegacy<uint64_t> m_words;
+
+    static size_t words_for(size_t bits) {
+        return (bits + 63) / 64;
+    }
+
+    // Количество единичных бит (инструкция popcnt)
+    static size_t popcount(uint64_t x) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return (size_t)__popcnt64(x);
+#elif defined(_MSC_VER)
+        return (size_t)__popcnt((unsigned int)x) + (size_t)__popcnt((unsigned int)(x >> 32));
+#else
+        return (size_t)__builtin_popcountll(x);
+#endif
+    }
+
+    // Номер младшего единичного бита, x != 0 (инструкция tzcnt/bsf)
+    static size_t lowest_bit(uint64_t x) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanForward64(&index, x);
+        return index;
+#elif defined(_MSC_VER)
+        unsigned long index;
+        if (_BitScanForward(&index, (unsigned long)x)) {
+            return index;
+        }
+        _BitScanForward(&index, (unsigned long)(x >> 32));
+        return index + 32;
+#else
+        return (size_t)__builtin_ctzll(x);
+#endif
+    }
+
+    // Маска бит [from, to) внутри слова, 0 <= from < to <= 64
+    static uint64_t mask(size_t from, size_t to) {
+        uint64_t high = to == 64 ? ~0ULL : (1ULL << to) - 1;
+        return high & ~((1ULL << from) - 1);
+    }
+
+    // Обнуление бит за пределами size() в последнем слове
+    void trim() {
+        if (m_size % 64 != 0) {
+            m_words.m_data[m_size / 64] &= mask(0, m_size % 64);
+        }
+    }
+
+    // Применяет op(слово, маска) к словам, покрывающим диапазон [first, first + count)
+    template <typename Op>
+    void apply_range(size_t first, size_t count, Op op) {
+        if (first > m_size || count > m_size - first) {
+            throw out_of_range("Invalid index or count");
+        }
+        if (count == 0) {
+            return;
+        }
+        size_t last = first + count;
+        size_t first_word = first / 64;
+        size_t last_word = (last - 1) / 64;
+        uint64_t* words = m_words.m_data;
+        if (first_word == last_word) {
+            op(words[first_word], mask(first % 64, (last - 1) % 64 + 1));
+            return;
+        }
+        op(words[first_word], mask(first % 64, 64));
+        for (size_t w = first_word + 1; w < last_word; ++w) {
+            op(words[w], ~0ULL);
+        }
+        op(words[last_word], mask(0, (last - 1) % 64 + 1));
+    }
+
+    // Поиск первого единичного бита начиная со слова w, в котором оставлены только биты word
+    size_t find_from(size_t w, uint64_t word) const {
+        size_t count = m_words.size();
+        for (;;) {
+            if (word != 0) {
+                return w * 64 + lowest_bit(word);
+            }
+            if (++w >= count) {
+                return m_size;
+            }
+            word = m_words.m_data[w];
+        }
+    }
+
+    // Первый нулевой флаг или size(), если таких нет
+    size_t find_zero() const {
+        size_t count = m_words.size();
+        for (size_t w = 0; w < count; ++w) {
+            uint64_t word = ~m_words.m_data[w];
+            if (w == count - 1 && m_size % 64 != 0) {
+                word &= mask(0, m_size % 64);
+            }
+            if (word != 0) {
+                return w * 64 + lowest_bit(word);
+            }
+        }
+        return m_size;
+    }
+
+    // 64 флага начиная с pos, за последним словом -- нули
+    uint64_t load(size_t pos) const {
+        size_t w = pos / 64;
+        size_t b = pos % 64;
+        uint64_t bits = w < m_words.size() ? m_words.m_data[w] >> b : 0;
+        if (b != 0 && w + 1 < m_words.size()) {
+            bits |= m_words.m_data[w + 1] << (64 - b);
+        }
+        return bits;
+    }
+
+    // Запись count (1..64) младших бит bits в флаги начиная с pos
+    void store(size_t pos, uint64_t bits, size_t count) {
+        uint64_t* words = m_words.m_data;
+        size_t w = pos / 64;
+        size_t b = pos % 64;
+        bits &= mask(0, count);
+        if (b + count <= 64) {
+            uint64_t m = mask(b, b + count);
+            words[w] = (words[w] & ~m) | (bits << b);
+            return;
+        }
+        words[w] = (words[w] & mask(0, b)) | (bits << b);
+        words[w + 1] = (words[w + 1] & ~mask(0, b + count - 64)) | (bits >> (64 - b));
+    }
+
+    // Перенос count флагов с позиции from на позицию to по 64 за раз. Диапазоны могут перекрываться:
+    // при переносе вправо идем с конца, чтобы не затереть еще не прочитанные флаги
+    void move_bits(size_t from, size_t to, size_t count) {
+        if (to < from) {
+            for (size_t done = 0; done < count;) {
+                size_t n = min((size_t)64, count - done);
+                store(to + done, load(from + done), n);
+                done += n;
+            }
+        }
+        else if (to > from) {
+            for (size_t done = count; done > 0;) {
+                size_t n = min((size_t)64, done);
+                done -= n;
+                store(to + done, load(from + done), n);
+            }
+        }
+    }
+
+    // Раздвигает флаги: после index появляется count нулевых флагов
+    void open_gap(size_t index, size_t count) {
+        if (index > m_size) {
+            throw out_of_range("Index out of range");
+        }
+        size_t tail = m_size - index;
+        size_t words = words_for(m_size + count);
+        m_words.reserve_for(words);
+        while (m_words.m_size < words) {
+            m_words.m_data[m_words.m_size++] = 0;
+        }
+        m_size += count;
+        move_bits(index, index + count, tail);
+        reset(index, count);
+    }
+
+    // Удаляет count флагов начиная с index, правые флаги сдвигаются влево
+    void close_gap(size_t index, size_t count) {
+        move_bits(index + count, index, m_size - index - count);
+        m_size -= count;
+        m_words.m_size = words_for(m_size);
+        trim();
+    }
+
+    // Проверка совпадения размеров для побитовых операций
+    void check_size(const VectorLegacy& other) const {
+        if (m_size != other.m_size) {
+            throw invalid_argument("Bit vectors have different sizes");
+        }
+    }
+
+public:
+    // Ссылка на отдельный бит
+    class reference {
+    private:
+        uint64_t* m_word;
+        uint64_t m_bit;
+
+    public:
+        reference(uint64_t* word, size_t bit) : m_word(word), m_bit(1ULL << bit) {
+        }
+
+        operator bool() const {
+            return (*m_word & m_bit) != 0;
+        }
+
+        reference& operator=(bool value) {
+            if (value) {
+                *m_word |= m_bit;
+            }
+            else {
+                *m_word &= ~m_bit;
+            }
+            return *this;
+        }
+
+        reference& operator=(const reference& other) {
+            return *this = (bool)other;
+        }
+
+        void flip() {
+            *m_word ^= m_bit;
+        }
+    };
+
+    // Итератор для чтения флагов по порядку
+    class const_iterator {
+    public:
+        typedef random_access_iterator_tag iterator_category;
+        typedef bool value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const bool* pointer;
+        typedef bool reference;
+
+        const_iterator() : m_owner(nullptr), m_index(0) {}
+        const_iterator(const VectorLegacy* owner, size_t index) : m_owner(owner), m_index(index) {}
+
+        bool operator*() const { return (*m_owner)[m_index]; }
+        bool operator[](difference_type n) const { return (*m_owner)[m_index + n]; }
+
+        const_iterator& operator++() { ++m_index; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++m_index; return old; }
+        const_iterator& operator--() { --m_index; return *this; }
+        const_iterator operator--(int) { const_iterator old = *this; --m_index; return old; }
+        const_iterator& operator+=(difference_type n) { m_index += n; return *this; }
+        const_iterator& operator-=(difference_type n) { m_index -= n; return *this; }
+        const_iterator operator+(difference_type n) const { return const_iterator(m_owner, m_index + n); }
+        const_iterator operator-(difference_type n) const { return const_iterator(m_owner, m_index - n); }
+        difference_type operator-(const const_iterator& other) const { return (difference_type)m_index - (difference_type)other.m_index; }
+
+        bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+        bool operator<(const const_iterator& other) const { return m_index < other.m_index; }
+
+    private:
+        const VectorLegacy* m_owner;
+        size_t m_index;
+    };
+
+//-----------------------------------ПРАВИЛО ПЯТИ--------------------------------
+    // Конструктор по умолчанию
+    VectorLegacy() : m_size(0) {
+    }
+
+    // Конструктор с указанием размера. Память -- ровно под n бит
+    VectorLegacy(size_t n, bool value = false) : m_size(n) {
+        size_t words = words_for(n);
+        m_words.reserve_for(words);
+        fill(m_words.m_data, m_words.m_data + words, value ? ~0ULL : 0ULL);
+        m_words.m_size = words;
+        trim();
+    }
+
+    //Конструктор с передачей элементов через список
+    VectorLegacy(initializer_list<bool> list) : m_size(0) {
+        m_words.reserve_for(words_for(list.size()));
+        for (bool value : list) {
+            push_back(value);
+        }
+    }
+
+    // Копирование, перемещение и деструктор -- через m_words
+    VectorLegacy(const VectorLegacy& other) = default;
+    VectorLegacy(VectorLegacy&& other) : m_size(other.m_size), m_words(std::move(other.m_words)) {
+        other.m_size = 0;
+    }
+    VectorLegacy& operator=(const VectorLegacy& other) = default;
+    VectorLegacy& operator=(VectorLegacy&& other) noexcept {
+        if (this != &other) {
+            m_size = other.m_size;
+            m_words = std::move(other.m_words);
+            other.m_size = 0;
+        }
+        return *this;
+    }
+
+    //Обмен массивов местами
+    void swap(VectorLegacy& other) {
+        std::swap(m_size, other.m_size);
+        m_words.swap(other.m_words);
+    }
+//----------------------------------------------------------------------------------------
+    //Оператор сравнения. Хвосты слов нулевые, поэтому сравниваются слова целиком
+    bool operator==(const VectorLegacy& other) const {
+        return m_size == other.m_size && m_words == other.m_words;
+    }
+
+    // Доступ к элементам через []
+    reference operator[](size_t index) {
+        if (index >= m_size) {
+            throw out_of_range("Tried to access to index out of array size");
+        }
+        return reference(m_words.m_data + index / 64, index % 64);
+    }
+
+    bool operator[](size_t index) const {
+        if (index >= m_size) {
+            throw out_of_range("Tried to access to index out of array size");
+        }
+        return (m_words.m_data[index / 64] >> (index % 64)) & 1;
+    }
+
+    reference at(size_t index) {
+        return (*this)[index];
+    }
+
+    bool at(size_t index) const {
+        return (*this)[index];
+    }
+
+    // Количество флагов
+    size_t size() const {
+        return m_size;
+    }
+
+    // Вместимость в флагах
+    size_t capacity() const {
+        return m_words.capacity() * 64;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    //Средний: О(n / 64)
+    //Отсортирован ли массив: все нули идут перед единицами
+    bool sorted() const {
+        size_t first = find_first();
+        return count() == m_size - first;
+    }
+
+    //Ссылка на последний флаг
+    reference back() {
+        if (m_size == 0) {
+            throw std::out_of_range("Vector is empty");
+        }
+        return (*this)[m_size - 1];
+    }
+
+    //Ссылка на первый флаг
+    reference data() {
+        if (m_size == 0) {
+            throw std::out_of_range("Vector is empty");
+        }
+        return (*this)[0];
+    }
+
+    //Итераторы для чтения флагов
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, m_size);
+    }
+
+    // Занимаемая память в байтах
+    size_t memory() const {
+        return m_words.capacity() * sizeof(uint64_t);
+    }
+
+//----------------------------------------------------------------Добавление и удаление элементов--------------------------------------------------
+    // Добавление флага в конец
+    // Средний: O(1)
+    void push_back(bool value) {
+        if (m_size % 64 == 0) {
+            m_words.push_back(0);
+        }
+        if (value) {
+            m_words.m_data[m_size / 64] |= 1ULL << (m_size % 64);
+        }
+        ++m_size;
+    }
+    // Удаление флага из конца
+    bool pop_back() {
+        if (m_size == 0) {
+            throw out_of_range("Array is empty");
+        }
+        bool result = (*this)[m_size - 1];
+        --m_size;
+        if (m_size % 64 == 0) {
+            m_words.pop_back();
+        }
+        else {
+            trim();
+        }
+        return result;
+    }
+    //Средний: О(n / 64)
+    // Удаление первого флага: остальные сдвигаются словами
+    void pop_front() {
+        if (m_size == 0) {
+            throw out_of_range("Array is empty");
+        }
+        close_gap(0, 1);
+    }
+    //Средний: О(n / 64)
+    // Добавление флага в начало
+    void push_front(bool value) {
+        insert(0, value);
+    }
+    //Средний: О(n / 64)
+    //Вставляет value в index
+    void insert(size_t index, bool value) {
+        open_gap(index, 1);
+        if (value) {
+            set(index);
+        }
+    }
+    //Средний: О(n / 64 + count)
+    //Вставляет count флагов из array в index
+    void insert(size_t index, const bool* array, size_t count) {
+        open_gap(index, count);
+        for (size_t i = 0; i < count; ++i) {
+            if (array[i]) {
+                set(index + i);
+            }
+        }
+    }
+    //Вставляет список в index
+    void insert(size_t index, const list<bool>& list) {
+        open_gap(index, list.size());
+        for (bool value : list) {
+            if (value) {
+                set(index);
+            }
+            ++index;
+        }
+    }
+    //Средний: О(n / 64)
+    //Удаление флага в index
+    void delete_(size_t index) {
+        if (index >= m_size) {
+            throw out_of_range("Invalid index");
+        }
+        close_gap(index, 1);
+    }
+    //Удаление count флагов начиная с index
+    void delete_(size_t index, size_t count) {
+        if (index > m_size || count > m_size - index) {
+            throw out_of_range("Invalid index or count");
+        }
+        close_gap(index, count);
+    }
+    //Средний: О(1)
+    // Очистка массива
+    void clear() {
+        m_size = 0;
+        m_words.m_size = 0;
+    }
+//----------------------------------------------------------------Работа с битами--------------------------------------------------
+    void set(size_t index) {
+        (*this)[index] = true;
+    }
+
+    void reset(size_t index) {
+        (*this)[index] = false;
+    }
+
+    void flip(size_t index) {
+        (*this)[index].flip();
+    }
+
+    //Средний: О(count / 64)
+    //Установка count флагов начиная с first
+    void set(size_t first, size_t count) {
+        apply_range(first, count, [](uint64_t& word, uint64_t bits) { word |= bits; });
+    }
+
+    //Сброс count флагов начиная с first
+    void reset(size_t first, size_t count) {
+        apply_range(first, count, [](uint64_t& word, uint64_t bits) { word &= ~bits; });
+    }
+
+    //Инверсия count флагов начиная с first
+    void flip(size_t first, size_t count) {
+        apply_range(first, count, [](uint64_t& word, uint64_t bits) { word ^= bits; });
+    }
+
+    // Установка, сброс и инверсия всех флагов
+    void set() {
+        set(0, m_size);
+    }
+
+    void reset() {
+        reset(0, m_size);
+    }
+
+    void flip() {
+        flip(0, m_size);
+    }
+
+    //Средний: О(n / 64)
+    //Количество установленных флагов
+    size_t count() const {
+        size_t result = 0;
+        for (const uint64_t* w = m_words.m_data, *last = w + m_words.m_size; w != last; ++w) {
+            result += popcount(*w);
+        }
+        return result;
+    }
+
+    //Обмен флагов местами
+    void swap(size_t index1, size_t index2) {
+        if (index1 >= m_size || index2 >= m_size) {
+            throw out_of_range("Invalid index");
+        }
+        bool first = (*this)[index1];
+        (*this)[index1] = (bool)(*this)[index2];
+        (*this)[index2] = first;
+    }
+
+    //Средний: О(n / 64)
+    //Позиция первого флага, равного value, или size()
+    size_t seek(bool value) const {
+        return value ? find_first() : find_zero();
+    }
+
+    //Средний: О(n / 64)
+    //Сортировка по возрастанию: флаги не переставляются, а считаются -- нули, затем count() единиц
+    void sort() {
+        size_t ones = count();
+        reset();
+        set(m_size - ones, ones);
+    }
+
+    //Первый установленный флаг или size(), если таких нет
+    size_t find_first() const {
+        if (m_size == 0) {
+            return m_size;
+        }
+        return find_from(0, m_words.m_data[0]);
+    }
+
+    //Первый установленный флаг после index или size(), если таких нет
+    size_t find_next(size_t index) const {
+        if (index + 1 >= m_size) {
+            return m_size;
+        }
+        ++index;
+        return find_from(index / 64, m_words.m_data[index / 64] & mask(index % 64, 64));
+    }
+
+    //Средний: О(n / 64)
+    //Побитовые операции с массивом того же размера
+    VectorLegacy& operator&=(const VectorLegacy& other) {
+        check_size(other);
+        for (size_t w = 0; w < m_words.size(); ++w) {
+            m_words.m_data[w] &= other.m_words.m_data[w];
+        }
+        return *this;
+    }
+
+    VectorLegacy& operator|=(const VectorLegacy& other) {
+        check_size(other);
+        for (size_t w = 0; w < m_words.size(); ++w) {
+            m_words.m_data[w] |= other.m_words.m_data[w];
+        }
+        return *this;
+    }
+
+    VectorLegacy& operator^=(const VectorLegacy& other) {
+        check_size(other);
+        for (size_t w = 0; w < m_words.size(); ++w) {
+            m_words.m_data[w] ^= other.m_words.m_data[w];
+        }
+        return *this;
+    }
+//-----------------------------------------------------------------------------------------------------------------------------------
+    //Средний: О(n)
+    // Конвертация массива в строку
+    std::string to_string() const {
+        stringstream ss;
+        ss << "[";
+        for (size_t i = 0; i < m_size; ++i) {
+            ss << (*this)[i];
+            if (i != m_size - 1) {
+                ss << ", ";
+            }
+        }
+        ss << "]";
+        return ss.str();
+    }
+
+    // Печать элементов
+    void print() const {
+        cout << to_string() << endl;
+    }
+};
+
+//Процедура тестирования битового массива
+void test_bool() {
+    VectorLegacy<bool> flags(100);
+    assert(flags.size() == 100 && flags.count() == 0);
+    assert(flags.memory() == 2 * sizeof(uint64_t));
+    assert(flags.find_first() == 100);
+
+    flags[3] = true;
+    flags.set(70);
+    assert(flags[3] && flags[70] && !flags[4]);
+    assert(flags.count() == 2);
+    assert(flags.find_first() == 3 && flags.find_next(3) == 70 && flags.find_next(70) == 100);
+
+    flags.set(60, 10);
+    assert(flags.count() == 12);
+    flags.flip(0, 100);
+    assert(flags.count() == 88 && !flags[65] && !flags[3] && flags[99]);
+    flags.reset();
+    assert(flags.count() == 0);
+
+    VectorLegacy<bool> ones(100, true);
+    assert(ones.count() == 100);
+    ones.pop_back();
+    assert(ones.size() == 99 && ones.count() == 99);
+    ones.push_back(false);
+    assert(ones.count() == 99 && !ones[99]);
+
+    VectorLegacy<bool> a({ true, true, false, false });
+    VectorLegacy<bool> b({ true, false, true, false });
+    VectorLegacy<bool> c(a);
+    c &= b;
+    assert(c == VectorLegacy<bool>({ true, false, false, false }));
+    c = a;
+    c |= b;
+    assert(c == VectorLegacy<bool>({ true, true, true, false }));
+    c = a;
+    c ^= b;
+    assert(c == VectorLegacy<bool>({ false, true, true, false }));
+    assert(c.to_string() == "[0, 1, 1, 0]");
+    c[0] = c[1];
+    assert(c[0]);
+
+    // Вставка и удаление в середине сдвигают флаги словами, в том числе через границы слов
+    VectorLegacy<bool> shifted;
+    for (int i = 0; i < 150; ++i) {
+        shifted.push_back(i % 3 == 0);
+    }
+    shifted.insert(5, true);
+    shifted.push_front(true);
+    assert(shifted.size() == 152 && shifted[0] && shifted[1] && shifted[6] && !shifted[7] && shifted[8]);
+    assert(shifted[151] == (149 % 3 == 0) && shifted.count() == 52);
+    shifted.pop_front();
+    shifted.delete_(5);
+    bool pattern[3] = { false, true, false };
+    shifted.insert(64, pattern, 3);
+    shifted.delete_(64, 3);
+    shifted.insert(100, list<bool>({ true, true }));
+    shifted.delete_(100, 2);
+    for (size_t i = 0; i < 150; ++i) {
+        assert(shifted[i] == (i % 3 == 0));
+    }
+    assert(shifted.back() == (149 % 3 == 0) && shifted.data());
+    size_t iterated = 0;
+    for (bool flag : shifted) {
+        iterated += flag;
+    }
+    assert(iterated == 50 && shifted.seek(true) == 0 && shifted.seek(false) == 1 && !shifted.sorted());
+    shifted.sort();
+    assert(shifted.sorted() && shifted.seek(true) == 100 && shifted.seek(false) == 0 && shifted.count() == 50);
+    VectorLegacy<bool> other_flags(3, true);
+    shifted.swap(other_flags);
+    assert(shifted.size() == 3 && other_flags.size() == 150 && other_flags[149]);
+    shifted.swap(0, 1);
+    assert(VectorLegacy<bool>(70, true).seek(false) == 70);
+
+    cout << "Bool tests passed!" << endl;
+}
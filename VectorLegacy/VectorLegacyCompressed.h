@@ -0,0 +1,322 @@
+#pragma once
+#include "VectorLegacy.h"
+#include <cstdint>
+#include <cstring>
+/*
+Сжатое представление отсортированного целочисленного массива.
+Значения разбиты на блоки по 128. В блоке хранятся разности соседних значений (дельты),
+упакованные по bits бит, где bits -- ширина наибольшей дельты блока (frame of reference).
+Если дельта не помещается в 32 бита, блок хранится без сжатия.
+
+Упаковка "вертикальная" на 4 полосы: значение i лежит в полосе i % 4, и слово w каждой
+из 4 полос стоит подряд. Поэтому одна 128-битная загрузка дает очередное слово всех полос,
+и SSE2 распаковывает по 4 значения за раз одинаковыми сдвигами и маской.
+
+Для каждого блока хранятся наименьшее и наибольшее значения. Поиск идет бинарно по
+наибольшим значениям блоков, а распаковывается только один блок.
+*/
+template <typename T>
+class VectorLegacyCompressed {
+    static_assert(is_integral<T>::value, "VectorLegacyCompressed needs an integral type");
+public:
+    // Количество значений в блоке
+    static const size_t BLOCK = 128;
+
+private:
+    typedef typename make_unsigned<T>::type U;
+    // Метка блока без сжатия
+    static const unsigned char RAW = 255;
+
+    // Количество значений
+    size_t m_size;
+    // Первое (наименьшее) значение каждого блока
+    VectorLegacy<T> m_mins;
+    // Последнее (наибольшее) значение каждого блока
+    VectorLegacy<T> m_maxs;
+    // Начало блока в m_words
+    VectorLegacy<size_t> m_offsets;
+    // Ширина дельты в битах или RAW
+    VectorLegacy<unsigned char> m_bits;
+    // Упакованные дельты всех блоков
+    VectorLegacy<uint32_t> m_words;
+
+    // Количество бит, нужное для записи x
+    static unsigned bit_width(uint64_t x) {
+        unsigned bits = 0;
+        while (x != 0) {
+            ++bits;
+            x >>= 1;
+        }
+        return bits;
+    }
+
+    // Количество 32-битных слов блока из count значений
+    static size_t block_words(unsigned bits, size_t count) {
+        return bits == RAW ? (count * sizeof(T) + 3) / 4 : 4 * bits;
+    }
+
+    // Упаковка 128 дельт по bits бит в вертикальном формате
+    static void pack(const uint32_t* deltas, unsigned bits, uint32_t* out) {
+        // Все дельты нулевые -- блок не занимает слов
+        if (bits == 0) {
+            return;
+        }
+        memset(out, 0, 4 * bits * sizeof(uint32_t));
+        for (size_t i = 0; i < BLOCK; ++i) {
+            size_t lane = i % 4;
+            size_t position = (i / 4) * bits;
+            size_t word = position / 32;
+            unsigned shift = position % 32;
+            out[4 * word + lane] |= deltas[i] << shift;
+            if (shift + bits > 32) {
+                out[4 * (word + 1) + lane] |= deltas[i] >> (32 - shift);
+            }
+        }
+    }
+
+    // Распаковка 128 дельт
+    static void unpack(const uint32_t* in, unsigned bits, uint32_t* deltas) {
+        if (bits == 0) {
+            memset(deltas, 0, BLOCK * sizeof(uint32_t));
+            return;
+        }
+        uint32_t mask = bits == 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+#ifdef VECTORLEGACY_SSE2
+        __m128i vmask = _mm_set1_epi32((int)mask);
+        for (size_t j = 0; j < BLOCK / 4; ++j) {
+            size_t position = j * bits;
+            size_t word = position / 32;
+            unsigned shift = position % 32;
+            __m128i v = _mm_srl_epi32(_mm_loadu_si128((const __m128i*)(in + 4 * word)), _mm_cvtsi32_si128((int)shift));
+            if (shift + bits > 32) {
+                __m128i high = _mm_loadu_si128((const __m128i*)(in + 4 * (word + 1)));
+                v = _mm_or_si128(v, _mm_sll_epi32(high, _mm_cvtsi32_si128((int)(32 - shift))));
+            }
+            _mm_storeu_si128((__m128i*)(deltas + 4 * j), _mm_and_si128(v, vmask));
+        }
+#else
+        for (size_t i = 0; i < BLOCK; ++i) {
+            size_t lane = i % 4;
+            size_t position = (i / 4) * bits;
+            size_t word = position / 32;
+            unsigned shift = position % 32;
+            uint64_t v = in[4 * word + lane] >> shift;
+            if (shift + bits > 32) {
+                v |= (uint64_t)in[4 * (word + 1) + lane] << (32 - shift);
+            }
+            deltas[i] = (uint32_t)v & mask;
+        }
+#endif
+    }
+
+    // Количество значений в блоке b
+    size_t block_size(size_t b) const {
+        return min(BLOCK, m_size - b * BLOCK);
+    }
+
+    // Распаковка блока b в out (не меньше block_size(b) значений)
+    void decode_block(size_t b, T* out) const {
+        const uint32_t* in = m_words.m_data + m_offsets[b];
+        unsigned bits = m_bits[b];
+        size_t count = block_size(b);
+        if (bits == RAW) {
+            memcpy(out, in, count * sizeof(T));
+            return;
+        }
+        uint32_t deltas[BLOCK];
+        unpack(in, bits, deltas);
+        U value = (U)m_mins[b];
+        for (size_t i = 0; i < count; ++i) {
+            value += (U)deltas[i];
+            out[i] = (T)value;
+        }
+    }
+
+public:
+    VectorLegacyCompressed() : m_size(0) {
+    }
+
+    //Сжатие отсортированного массива
+    explicit VectorLegacyCompressed(const VectorLegacy<T>& source) : m_size(source.size()) {
+        if (!source.sorted() && source.size() > 1) {
+            throw std::runtime_error("Array is not sorted");
+        }
+        VectorLegacy<T> scratch;
+        const T* data = source.contiguous(scratch);
+        size_t blocks = (m_size + BLOCK - 1) / BLOCK;
+        m_offsets.reserve_for(blocks);
+        m_bits.reserve_for(blocks);
+        m_mins.reserve_for(blocks);
+        m_maxs.reserve_for(blocks);
+
+        // Первый проход: ширина каждого блока и общий объем
+        size_t total = 0;
+        for (size_t b = 0; b < blocks; ++b) {
+            const T* block = data + b * BLOCK;
+            size_t count = min(BLOCK, m_size - b * BLOCK);
+            uint64_t widest = 0;
+            for (size_t i = 1; i < count; ++i) {
+                widest = max(widest, (uint64_t)(U)((U)block[i] - (U)block[i - 1]));
+            }
+            unsigned bits = bit_width(widest);
+            if (bits > 32) {
+                bits = RAW;
+            }
+            m_mins.m_data[b] = block[0];
+            m_maxs.m_data[b] = block[count - 1];
+            m_bits.m_data[b] = (unsigned char)bits;
+            m_offsets.m_data[b] = total;
+            total += block_words(bits, count);
+        }
+        m_mins.m_size = m_maxs.m_size = m_bits.m_size = m_offsets.m_size = blocks;
+        m_mins.m_sorted = m_maxs.m_sorted = true;
+
+        // Второй проход: упаковка
+        m_words.reserve_for(total);
+        m_words.m_size = total;
+        uint32_t deltas[BLOCK];
+        for (size_t b = 0; b < blocks; ++b) {
+            const T* block = data + b * BLOCK;
+            size_t count = block_size(b);
+            uint32_t* out = m_words.m_data + m_offsets.m_data[b];
+            if (m_bits.m_data[b] == RAW) {
+                memcpy(out, block, count * sizeof(T));
+                continue;
+            }
+            // Первая дельта -- от наименьшего значения блока до него самого, хвост дополняется нулями
+            deltas[0] = 0;
+            for (size_t i = 1; i < BLOCK; ++i) {
+                deltas[i] = i < count ? (uint32_t)((U)block[i] - (U)block[i - 1]) : 0;
+            }
+            pack(deltas, m_bits.m_data[b], out);
+        }
+    }
+
+    //Обратное преобразование в обычный массив
+    VectorLegacy<T> decompress() const {
+        VectorLegacy<T> result;
+        result.reserve_for(m_size);
+        size_t blocks = m_bits.size();
+        T tail[BLOCK];
+        for (size_t b = 0; b < blocks; ++b) {
+            if (block_size(b) == BLOCK) {
+                decode_block(b, result.m_data + b * BLOCK);
+            }
+            else {
+                decode_block(b, tail);
+                copy(tail, tail + block_size(b), result.m_data + b * BLOCK);
+            }
+        }
+        result.m_size = m_size;
+        result.m_sorted = true;
+        return result;
+    }
+
+    // Количество значений
+    size_t size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    // Занимаемая память в байтах
+    size_t memory() const {
+        return m_words.capacity() * sizeof(uint32_t) + m_offsets.capacity() * sizeof(size_t)
+            + m_bits.capacity() + (m_mins.capacity() + m_maxs.capacity()) * sizeof(T);
+    }
+
+    //Средний: О(1), распаковывается один блок
+    //Значение по индексу
+    T at(size_t index) const {
+        if (index >= m_size) {
+            throw out_of_range("Tried to access to index out of range (array size)");
+        }
+        T block[BLOCK];
+        decode_block(index / BLOCK, block);
+        return block[index % BLOCK];
+    }
+
+    T operator[](size_t index) const {
+        return at(index);
+    }
+
+    //Средний: О(log(n)) по заголовкам блоков + распаковка одного блока
+    //Первая позиция, где значение не меньше value
+    size_t lower_bound(const T& value) const {
+        T found = T();
+        return locate(value, found);
+    }
+
+    //Поиск значения. Возвращает size(), если не найдено. Блок распаковывается один раз
+    size_t seek(const T& value) const {
+        T found = T();
+        size_t index = locate(value, found);
+        if (index == m_size || found != value) {
+            return m_size;
+        }
+        return index;
+    }
+
+private:
+    // lower_bound, который заодно возвращает в found значение на найденной позиции (если она меньше size()).
+    // Блок с value уже распакован здесь, поэтому seek не распаковывает его повторно через at()
+    size_t locate(const T& value, T& found) const {
+        size_t b = (size_t)(std::lower_bound(m_maxs.m_data, m_maxs.m_data + m_maxs.m_size, value) - m_maxs.m_data);
+        if (b == m_maxs.size()) {
+            return m_size;
+        }
+        // Первый элемент блока -- его минимум
+        if (!(m_mins[b] < value)) {
+            found = m_mins[b];
+            return b * BLOCK;
+        }
+        T block[BLOCK];
+        decode_block(b, block);
+        // value не больше максимума блока, поэтому позиция внутри блока
+        size_t offset = (size_t)(std::lower_bound(block, block + block_size(b), value) - block);
+        found = block[offset];
+        return b * BLOCK + offset;
+    }
+};
+
+template <typename T>
+const size_t VectorLegacyCompressed<T>::BLOCK;
+
+template <typename T>
+const unsigned char VectorLegacyCompressed<T>::RAW;
+
+//Процедура тестирования сжатого представления
+void test_compressed() {
+    VectorLegacy<int> ids;
+    for (int i = 0; i < 1000; ++i) {
+        ids.push_back(i * 3 + (i % 7));
+    }
+    ids.sort();
+    VectorLegacyCompressed<int> packed = ids.compress();
+    assert(packed.size() == 1000);
+    assert(packed.memory() < ids.size() * sizeof(int));
+    for (size_t i = 0; i < ids.size(); ++i) {
+        assert(packed[i] == ids[i]);
+        assert(packed.seek(ids[i]) == ids.seek(ids[i]));
+    }
+    assert(packed.seek(-1) == 1000 && packed.seek(1) == 1000 && packed.seek(100000) == 1000);
+    assert(packed.lower_bound(4) == 1 && packed.lower_bound(5) == 2);
+    assert(packed.decompress() == ids);
+    assert(packed.decompress().sorted());
+
+    // Большие разрывы: блок хранится без сжатия
+    VectorLegacy<long long> wide({ -5000000000LL, 0, 7, 9000000000LL });
+    VectorLegacyCompressed<long long> wide_packed(wide);
+    assert(wide_packed.decompress() == wide);
+    assert(wide_packed.seek(7) == 2 && wide_packed.seek(8) == 4);
+
+    // Отрицательные значения и повторы
+    VectorLegacy<int> negative({ -10, -10, -3, 0, 0, 0, 5 });
+    VectorLegacyCompressed<int> negative_packed = negative.compress();
+    assert(negative_packed.decompress() == negative);
+    assert(negative_packed.lower_bound(0) == 3);
+
+    cout << "Compressed tests passed!" << endl;
+}
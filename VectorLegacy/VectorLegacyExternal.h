@@ -0,0 +1,594 @@
+#pragma once
+#include "VectorLegacy.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <future>
+#include <string>
+/*
+Внешняя сортировка для данных больше оперативной памяти.
+Элементы копятся в буфере размером с половину лимита памяти; заполненный буфер сортируется
+обычной сортировкой VectorLegacy и сбрасывается во временный файл (серию). Вторая половина
+лимита остается под буфер слияния сортировки. Перед слиянием буфер серии освобождается,
+и весь лимит идет на блоки слияния. В конце серии сливаются k-путевым слиянием
+с деревом проигравших: на элемент log2(k) сравнений. Чтение серий и запись результата идут
+большими последовательными блоками с двойной буферизацией: пока слияние разбирает один блок,
+следующий читается (или предыдущий пишется) в фоне.
+Если серий больше, чем блоков помещается в лимит, слияние идет в несколько проходов.
+Результат -- файловый массив VectorLegacyFile: двоичный файл из подряд записанных элементов.
+Работает только с тривиально копируемыми типами.
+*/
+
+//Файловый массив: элементы T подряд в двоичном файле
+template <typename T>
+class VectorLegacyFile {
+    static_assert(is_trivially_copyable<T>::value, "VectorLegacyFile needs a trivially copyable type");
+private:
+    // Путь к файлу
+    string m_path;
+    // Количество элементов
+    size_t m_size;
+
+public:
+    // Открытие файла. Ошибка -- исключение
+    static FILE* open(const string& path, const char* mode) {
+        FILE* file = nullptr;
+#ifdef _MSC_VER
+        if (fopen_s(&file, path.c_str(), mode) != 0) {
+            file = nullptr;
+        }
+#else
+        file = fopen(path.c_str(), mode);
+#endif
+        if (file == nullptr) {
+            throw runtime_error("Cannot open file " + path);
+        }
+        return file;
+    }
+
+    // Переход к байту offset (файлы больше 2 ГБ)
+    static void seek(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+        int result = _fseeki64(file, (long long)offset, SEEK_SET);
+#else
+        int result = fseeko(file, (off_t)offset, SEEK_SET);
+#endif
+        if (result != 0) {
+            throw runtime_error("Cannot seek in file");
+        }
+    }
+
+    // Размер файла в байтах
+    static uint64_t file_bytes(FILE* file) {
+#ifdef _WIN32
+        _fseeki64(file, 0, SEEK_END);
+        long long bytes = _ftelli64(file);
+#else
+        fseeko(file, 0, SEEK_END);
+        long long bytes = (long long)ftello(file);
+#endif
+        if (bytes < 0) {
+            throw runtime_error("Cannot get file size");
+        }
+        seek(file, 0);
+        return (uint64_t)bytes;
+    }
+
+    VectorLegacyFile() : m_size(0) {
+    }
+
+    //Открытие существующего файла
+    explicit VectorLegacyFile(const string& path) : m_path(path) {
+        FILE* file = open(path, "rb");
+        m_size = (size_t)(file_bytes(file) / sizeof(T));
+        fclose(file);
+    }
+
+    //Запись массива в файл path (файл перезаписывается)
+    static VectorLegacyFile write(const string& path, const VectorLegacy<T>& data) {
+        FILE* file = open(path, "wb");
+        size_t written = 0;
+        data.for_runs(0, data.size(), [&](const T* p, size_t n) {
+            written += fwrite(p, sizeof(T), n, file);
+        });
+        fclose(file);
+        if (written != data.size()) {
+            throw runtime_error("Cannot write file " + path);
+        }
+        return VectorLegacyFile(path);
+    }
+
+    // Путь к файлу
+    const string& path() const {
+        return m_path;
+    }
+
+    // Количество элементов
+    size_t size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    //Чтение count элементов начиная с first в out (не дальше конца файла). Возвращает количество прочитанных.
+    //Файл короче ожидаемого или ошибка чтения -- runtime_error
+    size_t read(size_t first, size_t count, T* out) const {
+        if (first > m_size) {
+            throw out_of_range("Invalid index");
+        }
+        count = min(count, m_size - first);
+        FILE* file = open(m_path, "rb");
+        seek(file, (uint64_t)first * sizeof(T));
+        size_t result = fread(out, sizeof(T), count, file);
+        fclose(file);
+        if (result != count) {
+            throw runtime_error("Cannot read file " + m_path);
+        }
+        return result;
+    }
+
+    //Элемент по индексу. Каждое обращение читает файл, для обхода -- read и load
+    T at(size_t index) const {
+        if (index >= m_size) {
+            throw out_of_range("Tried to access to index out of range (array size)");
+        }
+        T value;
+        read(index, 1, &value);
+        return value;
+    }
+
+    T operator[](size_t index) const {
+        return at(index);
+    }
+
+    //Загрузка count элементов начиная с first в память
+    VectorLegacy<T> load(size_t first, size_t count) const {
+        if (first > m_size || count > m_size - first) {
+            throw out_of_range("Invalid index or count");
+        }
+        VectorLegacy<T> result;
+        result.reserve_for(count);
+        read(first, count, result.m_data);
+        result.m_size = count;
+        return result;
+    }
+};
+
+//Внешняя сортировка: элементы добавляются через push_back/append, finish записывает результат
+template <typename T, typename Compare = less<T>>
+class VectorLegacyExternalSort {
+    static_assert(is_trivially_copyable<T>::value, "VectorLegacyExternalSort needs a trivially copyable type");
+private:
+    // Наименьший блок чтения и записи при слиянии
+    static const size_t MIN_BLOCK_BYTES = 64 * 1024;
+
+    // Лимит памяти в байтах
+    size_t m_memory;
+    // Каталог временных файлов
+    string m_temp_dir;
+    Compare m_comp;
+    // Вместимость буфера серии
+    size_t m_run_capacity;
+    // Текущая серия
+    VectorLegacy<T> m_run;
+    // Файлы сброшенных серий по порядку
+    VectorLegacy<string> m_files;
+    // Счетчик для имен временных файлов
+    size_t m_counter;
+
+    // Имя нового временного файла
+    string temp_path() {
+        string name = "vectorlegacy-" + std::to_string((uintptr_t)this) + "-"
+            + std::to_string((long long)chrono::steady_clock::now().time_since_epoch().count()) + "-"
+            + std::to_string(m_counter++) + ".run";
+        return m_temp_dir + "/" + name;
+    }
+
+    // Сортировка текущей серии и сброс ее во временный файл
+    void spill() {
+        if (m_run.m_size == 0) {
+            return;
+        }
+        m_run.sort(m_comp);
+        string path = temp_path();
+        VectorLegacyFile<T>::write(path, m_run);
+        m_files.push_back(path);
+        m_run.m_size = 0;
+        m_run.m_sorted = false;
+    }
+
+    // Буфер серии растет по мере добавления, но не больше m_run_capacity: малый ввод не занимает
+    // весь лимит памяти. В finish буфер освобождается и при следующем добавлении выделяется снова
+    void grow_run(size_t count) {
+        if (m_run.m_size + count > m_run.m_capacity && m_run.m_capacity < m_run_capacity) {
+            m_run.resize(min(m_run_capacity, max(m_run.m_size + count, max(m_run.m_capacity * 2, (size_t)16))));
+        }
+    }
+
+    // Чтение серии блоками: пока слияние разбирает текущий блок, следующий читается в фоне
+    class Reader {
+    private:
+        FILE* m_file;
+        string m_path;
+        // Сколько элементов файла еще не запрошено
+        size_t m_remaining;
+        // Размер блока, читаемого в фоне
+        size_t m_requested;
+        size_t m_block;
+        VectorLegacy<T> m_buffers[2];
+        size_t m_current;
+        size_t m_position;
+        future<size_t> m_pending;
+
+        // Фоновое чтение следующего блока в свободный буфер
+        void prefetch() {
+            size_t count = min(m_block, m_remaining);
+            m_remaining -= count;
+            m_requested = count;
+            T* data = m_buffers[m_current ^ 1].m_data;
+            FILE* file = m_file;
+            m_pending = async(launch::async, [file, data, count]() { return fread(data, sizeof(T), count, file); });
+        }
+
+    public:
+        Reader(const string& path, size_t block) : m_path(path), m_requested(0), m_block(block), m_current(0), m_position(0) {
+            m_file = VectorLegacyFile<T>::open(path, "rb");
+            m_remaining = (size_t)(VectorLegacyFile<T>::file_bytes(m_file) / sizeof(T));
+            for (size_t i = 0; i < 2; ++i) {
+                m_buffers[i].reserve_for(block);
+            }
+            prefetch();
+            next_block();
+        }
+
+        ~Reader() {
+            if (m_pending.valid()) {
+                m_pending.wait();
+            }
+            fclose(m_file);
+        }
+
+        // Переход к прочитанному в фоне блоку и запуск чтения следующего
+        void next_block() {
+            m_current ^= 1;
+            size_t count = m_pending.valid() ? m_pending.get() : 0;
+            // Короткий блок -- файл серии обрезан или не читается
+            if (count != m_requested) {
+                throw runtime_error("Cannot read file " + m_path);
+            }
+            m_buffers[m_current].m_size = count;
+            m_requested = 0;
+            m_position = 0;
+            if (m_remaining != 0) {
+                prefetch();
+            }
+        }
+
+        bool done() const {
+            return m_position == m_buffers[m_current].m_size;
+        }
+
+        const T& head() const {
+            return m_buffers[m_current].m_data[m_position];
+        }
+
+        void advance() {
+            if (++m_position == m_buffers[m_current].m_size) {
+                next_block();
+            }
+        }
+    };
+
+    // Запись блоками: пока слияние заполняет один буфер, предыдущий пишется в фоне
+    class Writer {
+    private:
+        FILE* m_file;
+        string m_path;
+        VectorLegacy<T> m_buffers[2];
+        size_t m_current;
+        future<bool> m_pending;
+
+        void wait() {
+            if (m_pending.valid() && !m_pending.get()) {
+                throw runtime_error("Cannot write file " + m_path);
+            }
+        }
+
+    public:
+        Writer(const string& path, size_t block) : m_path(path), m_current(0) {
+            m_file = VectorLegacyFile<T>::open(path, "wb");
+            for (size_t i = 0; i < 2; ++i) {
+                m_buffers[i].reserve_for(block);
+            }
+        }
+
+        ~Writer() {
+            if (m_pending.valid()) {
+                m_pending.wait();
+            }
+            if (m_file != nullptr) {
+                fclose(m_file);
+            }
+        }
+
+        void push_back(const T& value) {
+            VectorLegacy<T>& buffer = m_buffers[m_current];
+            buffer.m_data[buffer.m_size++] = value;
+            if (buffer.m_size == buffer.m_capacity) {
+                flush();
+            }
+        }
+
+        // Фоновая запись текущего буфера
+        void flush() {
+            wait();
+            VectorLegacy<T>& buffer = m_buffers[m_current];
+            const T* data = buffer.m_data;
+            size_t count = buffer.m_size;
+            FILE* file = m_file;
+            m_pending = async(launch::async, [file, data, count]() { return fwrite(data, sizeof(T), count, file) == count; });
+            m_current ^= 1;
+            m_buffers[m_current].m_size = 0;
+        }
+
+        void close() {
+            flush();
+            wait();
+            int result = fclose(m_file);
+            m_file = nullptr;
+            if (result != 0) {
+                throw runtime_error("Cannot write file " + m_path);
+            }
+        }
+    };
+
+    // Слияние файлов inputs[first, last) в файл output через дерево проигравших.
+    // Листья -- серии, во внутренних узлах хранятся проигравшие, в tree[0] -- победитель.
+    // При равенстве побеждает серия с меньшим номером, поэтому сортировка устойчива
+    void merge_files(size_t first, size_t last, const string& output) {
+        size_t k = last - first;
+        size_t block = max(MIN_BLOCK_BYTES / sizeof(T), m_memory / ((2 * k + 2) * sizeof(T)));
+        VectorLegacy<Reader*> owned;
+        owned.reserve_for(k);
+        Reader** readers = owned.m_data;
+        try {
+            for (; owned.m_size < k; ++owned.m_size) {
+                readers[owned.m_size] = new Reader(m_files[first + owned.m_size], block);
+            }
+            Writer writer(output, block);
+            // Побеждает ли серия a серию b. Закончившаяся серия проигрывает всем
+            auto beats = [&](size_t a, size_t b) {
+                if (readers[b]->done()) {
+                    return !readers[a]->done();
+                }
+                if (readers[a]->done()) {
+                    return false;
+                }
+                const T& x = readers[a]->head();
+                const T& y = readers[b]->head();
+                return m_comp(x, y) || (!m_comp(y, x) && a < b);
+            };
+
+            // Построение: победители поддеревьев снизу вверх, проигравшие остаются в узлах
+            VectorLegacy<size_t> nodes;
+            nodes.reserve_for(3 * k);
+            size_t* tree = nodes.m_data;
+            size_t* winners = nodes.m_data + k;
+            for (size_t i = 0; i < k; ++i) {
+                winners[k + i] = i;
+            }
+            for (size_t node = k - 1; node >= 1; --node) {
+                size_t a = winners[2 * node];
+                size_t b = winners[2 * node + 1];
+                winners[node] = beats(a, b) ? a : b;
+                tree[node] = beats(a, b) ? b : a;
+            }
+            tree[0] = k == 1 ? 0 : winners[1];
+
+            while (!readers[tree[0]]->done()) {
+                size_t winner = tree[0];
+                writer.push_back(readers[winner]->head());
+                readers[winner]->advance();
+                // Новый элемент серии проходит путь от листа к корню
+                for (size_t node = (winner + k) / 2; node >= 1; node /= 2) {
+                    if (beats(tree[node], winner)) {
+                        std::swap(tree[node], winner);
+                    }
+                }
+                tree[0] = winner;
+            }
+            writer.close();
+        }
+        catch (...) {
+            for (size_t i = 0; i < owned.m_size; ++i) {
+                delete readers[i];
+            }
+            throw;
+        }
+        for (size_t i = 0; i < k; ++i) {
+            delete readers[i];
+        }
+    }
+
+public:
+    //Системный каталог временных файлов: TMPDIR (иначе /tmp), в Windows -- GetTempPath
+    static string default_temp_dir() {
+        string dir;
+#ifdef _WIN32
+        char buffer[MAX_PATH + 1];
+        DWORD length = GetTempPathA(MAX_PATH + 1, buffer);
+        dir = length != 0 && length <= MAX_PATH ? string(buffer, length) : string(".");
+#else
+        const char* env = getenv("TMPDIR");
+        dir = env != nullptr && *env != '\0' ? string(env) : string("/tmp");
+#endif
+        while (dir.size() > 1 && (dir[dir.size() - 1] == '/' || dir[dir.size() - 1] == '\\')) {
+            dir.erase(dir.size() - 1);
+        }
+        return dir;
+    }
+
+    //memory_bytes -- лимит памяти, 0 -- половина свободной памяти (GetFreeMemory).
+    //temp_dir -- каталог для временных файлов серий, "" -- default_temp_dir()
+    explicit VectorLegacyExternalSort(size_t memory_bytes = 0, const string& temp_dir = "", Compare comp = Compare())
+        : m_memory(memory_bytes != 0 ? memory_bytes : VectorLegacy<T>::GetFreeMemory() / 2),
+        m_temp_dir(temp_dir.empty() ? default_temp_dir() : temp_dir), m_comp(comp), m_counter(0) {
+        m_memory = max(m_memory, 4 * MIN_BLOCK_BYTES);
+        m_run_capacity = m_memory / 2 / sizeof(T);
+    }
+
+    VectorLegacyExternalSort(const VectorLegacyExternalSort&) = delete;
+    VectorLegacyExternalSort& operator=(const VectorLegacyExternalSort&) = delete;
+
+    // Временные файлы удаляются, даже если finish не вызывался
+    ~VectorLegacyExternalSort() {
+        for (size_t i = 0; i < m_files.size(); ++i) {
+            std::remove(m_files[i].c_str());
+        }
+    }
+
+    //Средний: О(1), при заполнении серии -- ее сортировка и запись
+    //Добавление элемента
+    void push_back(const T& value) {
+        grow_run(1);
+        m_run.m_data[m_run.m_size++] = value;
+        if (m_run.m_size == m_run_capacity) {
+            spill();
+        }
+    }
+
+    //Добавление всего файлового массива. Читается прямо в буфер серии, большими блоками
+    void append(const VectorLegacyFile<T>& input) {
+        for (size_t done = 0; done < input.size();) {
+            grow_run(input.size() - done);
+            size_t count = input.read(done, m_run.m_capacity - m_run.m_size, m_run.m_data + m_run.m_size);
+            m_run.m_size += count;
+            done += count;
+            if (m_run.m_size == m_run_capacity) {
+                spill();
+            }
+        }
+    }
+
+    // Количество сброшенных на диск серий
+    size_t runs() const {
+        return m_files.size();
+    }
+
+    //Средний: О(n log(n)) сравнений, О(n log_k(runs)) ввода-вывода
+    //Слияние всех серий в файл output. После вызова сортировщик пуст и готов к новым данным
+    VectorLegacyFile<T> finish(const string& output) {
+        // Все поместилось в память -- файл пишется сразу
+        if (m_files.empty()) {
+            m_run.sort(m_comp);
+            VectorLegacyFile<T>::write(output, m_run);
+            m_run.m_size = 0;
+            m_run.m_sorted = false;
+            return VectorLegacyFile<T>(output);
+        }
+        spill();
+        // Буфер серии больше не нужен: весь лимит памяти уходит на блоки слияния
+        m_run = VectorLegacy<T>();
+
+        // Сколько серий сливать за раз: по два блока на серию и два на запись
+        size_t fan_in = max((size_t)2, m_memory / (2 * MIN_BLOCK_BYTES) - 1);
+        // Проход сливает соседние группы серий. Порядок серий сохраняется -- от него зависит устойчивость
+        while (m_files.size() > fan_in) {
+            VectorLegacy<string> merged;
+            try {
+                for (size_t first = 0; first < m_files.size(); first += fan_in) {
+                    size_t last = min(first + fan_in, m_files.size());
+                    if (last - first == 1) {
+                        merged.push_back(m_files[first]);
+                        continue;
+                    }
+                    merged.push_back(temp_path());
+                    merge_files(first, last, merged[merged.size() - 1]);
+                    for (size_t i = first; i < last; ++i) {
+                        std::remove(m_files[i].c_str());
+                    }
+                }
+            }
+            catch (...) {
+                for (size_t i = 0; i < merged.size(); ++i) {
+                    std::remove(merged[i].c_str());
+                }
+                throw;
+            }
+            m_files = std::move(merged);
+        }
+        merge_files(0, m_files.size(), output);
+        for (size_t i = 0; i < m_files.size(); ++i) {
+            std::remove(m_files[i].c_str());
+        }
+        m_files = VectorLegacy<string>();
+        return VectorLegacyFile<T>(output);
+    }
+};
+
+template <typename T, typename Compare>
+const size_t VectorLegacyExternalSort<T, Compare>::MIN_BLOCK_BYTES;
+
+//Средний: О(n log(n))
+//Сортировка файлового массива input в файл output с лимитом памяти memory_bytes (0 -- половина свободной)
+template <typename T, typename Compare = less<T>>
+VectorLegacyFile<T> external_sort(const VectorLegacyFile<T>& input, const string& output, size_t memory_bytes = 0,
+    const string& temp_dir = "", Compare comp = Compare()) {
+    VectorLegacyExternalSort<T, Compare> sorter(memory_bytes, temp_dir, comp);
+    sorter.append(input);
+    return sorter.finish(output);
+}
+
+//Процедура тестирования внешней сортировки
+void test_external() {
+    VectorLegacy<int> values;
+    srand(7);
+    for (int i = 0; i < 100000; ++i) {
+        values.push_back(rand() % 50000 - 25000);
+    }
+    // Файлы теста -- во временном каталоге, а не в текущем
+    string temp_dir = VectorLegacyExternalSort<int>::default_temp_dir();
+    string input_path = temp_dir + "/vectorlegacy-external-input.bin";
+    string output_path = temp_dir + "/vectorlegacy-external-output.bin";
+    VectorLegacyFile<int> input = VectorLegacyFile<int>::write(input_path, values);
+    assert(input.size() == 100000 && input[5] == values[5]);
+
+    // Лимит 256 КБ: серии по 32768 чисел, слияние в несколько проходов по 2 серии
+    VectorLegacyExternalSort<int> sorter(256 * 1024, temp_dir);
+    sorter.append(input);
+    assert(sorter.runs() == 3);
+    VectorLegacyFile<int> output = sorter.finish(output_path);
+    VectorLegacy<int> sorted = output.load(0, output.size());
+    values.sort();
+    assert(sorted == values);
+
+    // По убыванию, данные добавляются по одному
+    VectorLegacyExternalSort<int, greater<int>> descending(256 * 1024);
+    for (int i = 0; i < 70000; ++i) {
+        descending.push_back(i % 1000);
+    }
+    VectorLegacyFile<int> reversed = descending.finish(output_path);
+    assert(reversed.size() == 70000 && reversed[0] == 999 && reversed[69999] == 0);
+
+    // Все в памяти: без временных файлов
+    VectorLegacyFile<int> small = external_sort(VectorLegacyFile<int>::write(input_path, VectorLegacy<int>({ 3, 1, 2 })), output_path);
+    assert(small.load(0, 3) == VectorLegacy<int>({ 1, 2, 3 }));
+
+    // Файл обрезан после открытия: короткое чтение -- исключение, а не неинициализированные элементы
+    VectorLegacyFile<int> truncated(input_path);
+    VectorLegacyFile<int>::write(input_path, VectorLegacy<int>({ 3 }));
+    bool thrown = false;
+    try {
+        truncated.at(2);
+    }
+    catch (const runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::remove(input_path.c_str());
+    std::remove(output_path.c_str());
+    cout << "External sort tests passed!" << endl;
+}
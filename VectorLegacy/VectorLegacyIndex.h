@@ -0,0 +1,273 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <stddef.h>
+/*
+Хеш-индекс массива: значение -> первая позиция, где оно встречается.
+VectorLegacy хранит индекс через указатель на базовый класс, поэтому хеш и сравнение
+значений нужны только типам, для которых индекс включен (enable_index).
+Индекс либо актуален, либо устарел: любое изменение массива помечает его устаревшим,
+а операции, которые умеют обновлять индекс на месте, после обновления снова делают его актуальным.
+Устаревший индекс перестраивается целиком при следующем поиске.
+*/
+template <typename T>
+class VectorLegacyIndex {
+protected:
+    // Соответствует ли индекс содержимому массива
+    bool m_fresh;
+
+public:
+    // Позиция отсутствующего значения
+    static const size_t npos = SIZE_MAX;
+
+    VectorLegacyIndex() : m_fresh(false) {
+    }
+
+    virtual ~VectorLegacyIndex() {
+    }
+
+    bool fresh() const {
+        return m_fresh;
+    }
+
+    void invalidate() {
+        m_fresh = false;
+    }
+
+    // Пустой устаревший индекс того же вида -- для копий массива
+    virtual VectorLegacyIndex* clone_empty() const = 0;
+
+    // Построение заново по n элементам data
+    virtual void rebuild(const T* data, size_t n) = 0;
+
+    // Первая позиция value или npos
+    virtual size_t find(const T& value) const = 0;
+
+    // Методы ниже вызываются только для актуального индекса и оставляют его актуальным.
+    // data и n -- содержимое массива уже после изменения
+
+    // В конец добавлен элемент data[n - 1]
+    virtual void appended(const T* data, size_t n) = 0;
+
+    // Элемент data[position] вставлен, элементы правее сдвинулись на одну позицию вправо
+    virtual void inserted(const T* data, size_t n, size_t position) = 0;
+
+    // Элемент value удален с позиции position, элементы правее сдвинулись на одну позицию влево
+    virtual void erased(const T& value, size_t position, const T* data, size_t n) = 0;
+
+    // Элементы на позициях i и j обменялись
+    virtual void swapped(const T* data, size_t i, size_t j) = 0;
+};
+
+template <typename T>
+const size_t VectorLegacyIndex<T>::npos;
+
+/*
+Открытая адресация с линейным пробированием: значение и позиция лежат в одном слоте, поэтому
+поиск обычно укладывается в одну-две строки кэша. Заполнение не больше половины.
+Хеш перемешивается умножением на золотое сечение, так как std::hash для целых -- тождество.
+Удаление без меток-надгробий: следующие слоты цепочки сдвигаются назад.
+*/
+template <typename T, typename Hash = std::hash<T>>
+class VectorLegacyHashIndex : public VectorLegacyIndex<T> {
+private:
+    struct Slot {
+        // Позиция в массиве или npos для пустого слота
+        size_t position;
+        T value;
+    };
+
+    Slot* m_slots;
+    // Количество слотов (степень двойки) минус 1
+    size_t m_mask;
+    // Сдвиг, оставляющий от 64-битного произведения номер слота
+    unsigned m_shift;
+    // Количество занятых слотов
+    size_t m_count;
+    Hash m_hash;
+
+    using VectorLegacyIndex<T>::npos;
+    using VectorLegacyIndex<T>::m_fresh;
+
+    // Слот, с которого начинается поиск value
+    size_t home(const T& value) const {
+        return (size_t)(((uint64_t)m_hash(value) * 0x9E3779B97F4A7C15ULL) >> m_shift);
+    }
+
+    // Слот value или пустой слот, куда его можно положить
+    size_t probe(const T& value) const {
+        size_t i = home(value);
+        while (m_slots[i].position != npos && !(m_slots[i].value == value)) {
+            i = (i + 1) & m_mask;
+        }
+        return i;
+    }
+
+    // Пустая таблица не меньше чем на 2 * n значений
+    void reset(size_t n) {
+        size_t slots = 16;
+        unsigned shift = 60;
+        while (slots < 2 * n) {
+            slots *= 2;
+            --shift;
+        }
+        delete[] m_slots;
+        m_slots = new Slot[slots];
+        for (size_t i = 0; i < slots; ++i) {
+            m_slots[i].position = npos;
+        }
+        m_mask = slots - 1;
+        m_shift = shift;
+        m_count = 0;
+    }
+
+    // Запоминает position, если value еще нет или оно встречается позже
+    void add(const T& value, size_t position) {
+        if (2 * (m_count + 1) > m_mask + 1) {
+            grow();
+        }
+        size_t i = probe(value);
+        if (m_slots[i].position == npos) {
+            m_slots[i].value = value;
+            m_slots[i].position = position;
+            ++m_count;
+        }
+        else if (position < m_slots[i].position) {
+            m_slots[i].position = position;
+        }
+    }
+
+    // Удвоение таблицы
+    void grow() {
+        Slot* old = m_slots;
+        size_t old_slots = m_mask + 1;
+        m_slots = nullptr;
+        reset(old_slots);
+        for (size_t i = 0; i < old_slots; ++i) {
+            if (old[i].position != npos) {
+                Slot& slot = m_slots[probe(old[i].value)];
+                slot.value = std::move(old[i].value);
+                slot.position = old[i].position;
+                ++m_count;
+            }
+        }
+        delete[] old;
+    }
+
+    // Удаление занятого слота i со сдвигом цепочки назад
+    void remove(size_t i) {
+        size_t j = i;
+        for (;;) {
+            j = (j + 1) & m_mask;
+            if (m_slots[j].position == npos) {
+                break;
+            }
+            size_t k = home(m_slots[j].value);
+            // Слот j остается, если его начальный слот циклически лежит в (i, j]
+            if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) {
+                continue;
+            }
+            m_slots[i].value = std::move(m_slots[j].value);
+            m_slots[i].position = m_slots[j].position;
+            i = j;
+        }
+        m_slots[i].position = npos;
+        --m_count;
+    }
+
+    // Значение value переместилось с позиции from на позицию to, остальные его вхождения на месте
+    void relocate(const T& value, size_t from, size_t to, const T* data) {
+        Slot& slot = m_slots[probe(value)];
+        if (slot.position != from || to < from) {
+            slot.position = std::min(slot.position, to);
+            return;
+        }
+        size_t next = from + 1;
+        while (!(data[next] == value)) {
+            ++next;
+        }
+        slot.position = next;
+    }
+
+public:
+    VectorLegacyHashIndex() : m_slots(nullptr), m_mask(0), m_shift(64), m_count(0) {
+        reset(0);
+    }
+
+    VectorLegacyHashIndex(const VectorLegacyHashIndex&) = delete;
+    VectorLegacyHashIndex& operator=(const VectorLegacyHashIndex&) = delete;
+
+    ~VectorLegacyHashIndex() {
+        delete[] m_slots;
+    }
+
+    VectorLegacyIndex<T>* clone_empty() const {
+        return new VectorLegacyHashIndex();
+    }
+
+    void rebuild(const T* data, size_t n) {
+        reset(n);
+        for (size_t i = 0; i < n; ++i) {
+            size_t slot = probe(data[i]);
+            if (m_slots[slot].position == npos) {
+                m_slots[slot].value = data[i];
+                m_slots[slot].position = i;
+                ++m_count;
+            }
+        }
+        m_fresh = true;
+    }
+
+    size_t find(const T& value) const {
+        return m_slots[probe(value)].position;
+    }
+
+    void appended(const T* data, size_t n) {
+        add(data[n - 1], n - 1);
+        m_fresh = true;
+    }
+
+    void inserted(const T* data, size_t n, size_t position) {
+        // Вставка в конец не сдвигает позиций -- обход таблицы не нужен
+        for (size_t i = 0; position + 1 < n && i <= m_mask; ++i) {
+            if (m_slots[i].position != npos && m_slots[i].position >= position) {
+                ++m_slots[i].position;
+            }
+        }
+        add(data[position], position);
+        m_fresh = true;
+    }
+
+    void erased(const T& value, size_t position, const T* data, size_t n) {
+        // Удаление с конца (pop_back) не сдвигает позиций -- О(1) без обхода таблицы
+        for (size_t i = 0; position < n && i <= m_mask; ++i) {
+            if (m_slots[i].position != npos && m_slots[i].position > position) {
+                --m_slots[i].position;
+            }
+        }
+        size_t slot = probe(value);
+        if (m_slots[slot].position == position) {
+            // Удалено первое вхождение -- ищем следующее
+            size_t next = position;
+            while (next < n && !(data[next] == value)) {
+                ++next;
+            }
+            if (next < n) {
+                m_slots[slot].position = next;
+            }
+            else {
+                remove(slot);
+            }
+        }
+        m_fresh = true;
+    }
+
+    void swapped(const T* data, size_t i, size_t j) {
+        if (!(data[i] == data[j])) {
+            relocate(data[j], i, j, data);
+            relocate(data[i], j, i, data);
+        }
+        m_fresh = true;
+    }
+};
@@ -0,0 +1,229 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <type_traits>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VECTORLEGACY_SSE2
+#endif
+/*
+Алгоритмы над диапазоном элементов, общие для VectorLegacy и VectorLegacyView:
+разбиение, сортировка вставками, быстрая сортировка, интерполяционный поиск,
+заполнение и копирование буферов.
+Работают с указателем на буфер, поэтому массив и срез используют одну реализацию.
+Отрезки задаются индексами относительно data, как в методах VectorLegacy.
+*/
+struct VectorLegacyKernels {
+    //Разбиение Ломуто отрезка [low, high] со случайным опорным элементом.
+    //Возвращает позицию опорного: левее -- меньшие по comp, правее -- не меньшие
+    template <typename T, typename Compare>
+    static size_t partition(T* data, size_t low, size_t high, Compare comp) {
+        size_t pivot_index = low + rand() % (high - low + 1);
+        T pivot = data[pivot_index];
+        std::swap(data[pivot_index], data[high]);
+
+        // Граница меньших опорного
+        size_t i = low;
+        for (size_t j = low; j < high; j++) {
+            if (comp(data[j], pivot)) {
+                std::swap(data[i], data[j]);
+                i++;
+            }
+        }
+        std::swap(data[i], data[high]);
+        return i;
+    }
+
+    //Сортировка вставками [lo, hi)
+    template <typename T, typename Compare>
+    static void sort_insertion(T* data, size_t lo, size_t hi, Compare comp) {
+        for (size_t i = lo + 1; i < hi; ++i) {
+            T value = data[i];
+            size_t j = i;
+            while (j > lo && comp(value, data[j - 1])) {
+                data[j] = data[j - 1];
+                --j;
+            }
+            data[j] = value;
+        }
+    }
+
+    //Допустимая глубина разбиений быстрой сортировки n элементов: 2 * log2(n)
+    static size_t depth_limit(size_t n) {
+        size_t depth = 0;
+        for (; n > 1; n >>= 1) {
+            depth += 2;
+        }
+        return depth;
+    }
+
+    //Быстрая сортировка [low, high]. Рекурсия только в меньшую часть, поэтому стек О(log(n)).
+    //Короткие куски досортировываются вставками, при исчерпании depth -- пирамидальной сортировкой
+    template <typename T, typename Compare>
+    static void sort_quick(T* data, size_t low, size_t high, size_t depth, Compare comp) {
+        while (low < high && high - low >= 16) {
+            if (depth-- == 0) {
+                std::make_heap(data + low, data + high + 1, comp);
+                std::sort_heap(data + low, data + high + 1, comp);
+                return;
+            }
+            size_t pi = partition(data, low, high, comp);
+            if (pi - low < high - pi) {
+                if (pi > low) {
+                    sort_quick(data, low, pi - 1, depth, comp);
+                }
+                low = pi + 1;
+            }
+            else {
+                sort_quick(data, pi + 1, high, depth, comp);
+                if (pi == low) {
+                    return;
+                }
+                high = pi - 1;
+            }
+        }
+        if (low < high) {
+            sort_insertion(data, low, high + 1, comp);
+        }
+    }
+
+    //Средний: О(log(log(n))
+    //Интерполяционный поиск в отсортированном по возрастанию [data, data + n). Возвращает n, если не найдено.
+    //Поиск ограничен отрезком, где value между крайними значениями, поэтому промах не выводит индекс за границы
+    template <typename T, typename U>
+    static size_t seek_interpol(const T* data, size_t n, const U& value) {
+        if (n == 0 || value < data[0] || data[n - 1] < value) {
+            return n;
+        }
+
+        size_t left = 0;
+        size_t right = n - 1;
+        while (left <= right && !(value < data[left]) && !(data[right] < value)) {
+            // Все элементы на отрезке равны -- делить на разность нельзя
+            if (data[left] == data[right]) {
+                return data[left] == value ? left : n;
+            }
+            double fraction = ((double)value - (double)data[left]) / ((double)data[right] - (double)data[left]);
+            size_t mid = left + (size_t)((double)(right - left) * fraction);
+            if (data[mid] == value) {
+                return mid;
+            }
+            else if (data[mid] < value) {
+                left = mid + 1;
+            }
+            else {
+                if (mid == 0) {
+                    break;
+                }
+                right = mid - 1;
+            }
+        }
+        return n;
+    }
+
+    // Состоит ли value из одинаковых байт. Сам байт -- в byte
+    template <typename T>
+    static bool uniform_bytes(const T& value, unsigned char& byte, std::true_type) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+        byte = bytes[0];
+        for (size_t i = 1; i < sizeof(T); ++i) {
+            if (bytes[i] != byte) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename T>
+    static bool uniform_bytes(const T&, unsigned char&, std::false_type) {
+        return false;
+    }
+
+    //Заполнение n элементов тривиально копируемого типа. Значение из одинаковых байт (в том числе ноль) --
+    //через memset. stream -- потоковые записи SSE2 мимо кэша для буферов, которые в кэш не помещаются
+    template <typename T>
+    static void fill(T* dst, size_t n, const T& value, bool stream, std::true_type) {
+        unsigned char byte;
+        if (uniform_bytes(value, byte, std::true_type()) && !stream) {
+            memset(static_cast<void*>(dst), byte, n * sizeof(T));
+            return;
+        }
+#ifdef VECTORLEGACY_SSE2
+        if (stream && 16 % sizeof(T) == 0 && alignof(T) == sizeof(T)) {
+            // Голова до границы 16 байт
+            for (; n != 0 && reinterpret_cast<uintptr_t>(dst) % 16 != 0; --n) {
+                *dst++ = value;
+            }
+            unsigned char pattern[16];
+            for (size_t i = 0; i < 16; i += sizeof(T)) {
+                memcpy(pattern + i, &value, sizeof(T));
+            }
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+            size_t vectors = n * sizeof(T) / 16;
+            __m128i* out = reinterpret_cast<__m128i*>(dst);
+            for (size_t i = 0; i < vectors; ++i) {
+                _mm_stream_si128(out + i, v);
+            }
+            // Потоковые записи не упорядочены с обычными -- барьер до возврата
+            _mm_sfence();
+            size_t done = vectors * 16 / sizeof(T);
+            std::fill(dst + done, dst + n, value);
+            return;
+        }
+#endif
+        std::fill(dst, dst + n, value);
+    }
+
+    //Заполнение n элементов нетривиального типа -- присваиванием
+    template <typename T>
+    static void fill(T* dst, size_t n, const T& value, bool, std::false_type) {
+        std::fill(dst, dst + n, value);
+    }
+
+    //Копирование n элементов: тривиально копируемый тип -- через memcpy
+    template <typename T>
+    static void copy(T* dst, const T* src, size_t n, std::true_type) {
+        if (n != 0) {
+            memcpy(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+        }
+    }
+
+    template <typename T>
+    static void copy(T* dst, const T* src, size_t n, std::false_type) {
+        std::copy(src, src + n, dst);
+    }
+};
+
+// Ядра заполнения на малых размерах: в VectorLegacy потоковые записи включаются только от 32 МБ
+void test_kernels() {
+    // Невыровненное начало, хвост меньше 16 байт, соседние элементы не задеты
+    long long streamed[1027];
+    streamed[0] = streamed[1026] = -1;
+    VectorLegacyKernels::fill(streamed + 1, 1025, 0x0102030405060708LL, true, std::true_type());
+    assert(streamed[0] == -1 && streamed[1026] == -1);
+    for (int i = 1; i < 1026; ++i) {
+        assert(streamed[i] == 0x0102030405060708LL);
+    }
+    VectorLegacyKernels::fill(streamed + 1, 1025, 0LL, true, std::true_type());
+    assert(streamed[0] == -1 && streamed[1] == 0 && streamed[1025] == 0 && streamed[1026] == -1);
+    VectorLegacyKernels::fill(streamed + 1, 3, 7LL, false, std::true_type());
+    assert(streamed[0] == -1 && streamed[3] == 7 && streamed[4] == 0);
+
+    // Копирование: memcpy и присваивание
+    long long copied[1027];
+    VectorLegacyKernels::copy(copied, streamed, 1027, std::true_type());
+    assert(copied[0] == -1 && copied[2] == 7 && copied[1026] == -1);
+    std::string names[3] = { "a", "b", "c" };
+    std::string names_copy[3];
+    VectorLegacyKernels::copy(names_copy, names, 3, std::false_type());
+    assert(names_copy[0] == "a" && names_copy[2] == "c");
+    VectorLegacyKernels::fill(names_copy, 2, std::string("z"), false, std::false_type());
+    assert(names_copy[0] == "z" && names_copy[1] == "z" && names_copy[2] == "c");
+
+    std::cout << "Kernels tests passed!" << std::endl;
+}
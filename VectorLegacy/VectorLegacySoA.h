@@ -0,0 +1,199 @@
+#pragma once
+#include "VectorLegacy.h"
+#include <tuple>
+#include <utility>
+/*
+Хранилище записей по полям (struct of arrays): каждое поле лежит в своей непрерывной колонке
+VectorLegacy. Просмотр или сортировка по одному полю читает только байты этого поля,
+а не целые записи. Интерфейс добавления и удаления такой же, как у VectorLegacy,
+изменения применяются ко всем колонкам сразу, поэтому строки колонок всегда согласованы.
+*/
+template <typename... Fields>
+class VectorLegacySoA {
+    static_assert(sizeof...(Fields) > 0, "VectorLegacySoA needs at least one field");
+public:
+    // Тип поля с номером I
+    template <size_t I>
+    using field_type = typename tuple_element<I, tuple<Fields...>>::type;
+
+private:
+    // Колонки
+    tuple<VectorLegacy<Fields>...> m_columns;
+
+    typedef index_sequence_for<Fields...> indices;
+
+    // Вызывает f(колонка) для каждой колонки
+    template <typename F, size_t... I>
+    void for_each_column(F f, index_sequence<I...>) {
+        int expand[] = { 0, (f(std::get<I>(m_columns)), 0)... };
+        (void)expand;
+    }
+
+    template <typename F>
+    void for_each_column(F f) {
+        for_each_column(f, indices());
+    }
+
+    template <size_t... I>
+    void push_back(index_sequence<I...>, const Fields&... values) {
+        int expand[] = { 0, (std::get<I>(m_columns).push_back(values), 0)... };
+        (void)expand;
+    }
+
+    template <size_t... I>
+    void insert(index_sequence<I...>, size_t index, const Fields&... values) {
+        int expand[] = { 0, (std::get<I>(m_columns).insert(index, values), 0)... };
+        (void)expand;
+    }
+
+public:
+    // Количество записей
+    size_t size() const {
+        return std::get<0>(m_columns).size();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+//----------------------------------------------------------------Добавление и удаление записей--------------------------------------------------
+    // Добавление записи в конец
+    // Средний: O(1)
+    void push_back(const Fields&... values) {
+        push_back(indices(), values...);
+    }
+    //Средний: О(n)
+    //Вставляет запись в index
+    void insert(size_t index, const Fields&... values) {
+        if (index > size()) {
+            throw out_of_range("Index out of range");
+        }
+        insert(indices(), index, values...);
+    }
+    //Средний: О(n)
+    //Удаление записи в индексе
+    void delete_(size_t index) {
+        if (index >= size()) {
+            throw out_of_range("Invalid index");
+        }
+        for_each_column([index](auto& column) { column.delete_(index); });
+    }
+    //Средний: О(n)
+    //Удаление записей по диапазону
+    void delete_(size_t index, size_t count) {
+        if (index + count > size()) {
+            throw out_of_range("Invalid index or count");
+        }
+        for_each_column([index, count](auto& column) { column.delete_(index, count); });
+    }
+    // Очистка
+    void clear() {
+        for_each_column([](auto& column) { column.clear(); });
+    }
+//-----------------------------------------------------------------------------------------------------------------------------------
+    // Поле I записи row
+    template <size_t I>
+    field_type<I>& at(size_t row) {
+        if (row >= size()) {
+            throw out_of_range("Tried to access to index out of range (array size)");
+        }
+        return std::get<I>(m_columns)[row];
+    }
+
+    template <size_t I>
+    const field_type<I>& at(size_t row) const {
+        if (row >= size()) {
+            throw out_of_range("Tried to access to index out of range (array size)");
+        }
+        return std::get<I>(m_columns)[row];
+    }
+
+    // Колонка I целиком: непрерывный массив без лишних байтов, удобный для векторизации.
+    // Срез действителен до следующего добавления записей. Изменяемый срез снимает с колонки
+    // признак сортированности; для чтения -- константная перегрузка, она его сохраняет
+    template <size_t I>
+    VectorLegacyView<field_type<I>> column() {
+        return std::get<I>(m_columns).slice(0, size());
+    }
+
+    template <size_t I>
+    VectorLegacyView<const field_type<I>> column() const {
+        return std::get<I>(m_columns).slice(0, size());
+    }
+
+    //Поиск записи по значению поля I. Если колонка отсортирована -- интерполяционный
+    template <size_t I>
+    size_t seek(const field_type<I>& value) {
+        return std::get<I>(m_columns).seek(value);
+    }
+
+    //Все случаи O(n log(n))
+    //Устойчивая сортировка записей по полю I. Сортируются только пары (значение поля, номер записи),
+    //затем одна общая перестановка применяется ко всем колонкам
+    template <size_t I>
+    void sort_by() {
+        VectorLegacy<field_type<I>>& key = std::get<I>(m_columns);
+        size_t n = size();
+        if (key.m_sorted || n < 2) {
+            return;
+        }
+
+        VectorLegacy<pair<field_type<I>, size_t>> keys;
+        keys.reserve_for(n);
+        for (size_t i = 0; i < n; ++i) {
+            keys.m_data[i] = make_pair(key.m_data[i], i);
+        }
+        keys.m_size = n;
+        keys.sort();
+
+        VectorLegacy<size_t> order;
+        order.reserve_for(n);
+        for (size_t i = 0; i < n; ++i) {
+            order.m_data[i] = keys.m_data[i].second;
+        }
+        order.m_size = n;
+
+        for_each_column([&order](auto& column) {
+            column.gather(order.m_data);
+            column.m_sorted = false;
+        });
+        key.m_sorted = true;
+    }
+};
+
+//Процедура тестирования хранилища по полям
+void test_soa() {
+    VectorLegacySoA<int, double, string> records;
+    assert(records.empty());
+    records.push_back(3, 0.3, "c");
+    records.push_back(1, 0.1, "a");
+    records.push_back(2, 0.2, "b");
+    records.insert(1, 5, 0.5, "e");
+    assert(records.size() == 4);
+    assert(records.at<0>(1) == 5 && records.at<2>(1) == "e" && records.at<0>(2) == 1);
+
+    records.sort_by<0>();
+    assert(records.at<0>(0) == 1 && records.at<1>(0) == 0.1 && records.at<2>(0) == "a");
+    assert(records.at<0>(3) == 5 && records.at<2>(3) == "e");
+    assert(records.seek<0>(3) == 2);
+    assert(records.seek<2>("b") == 1);
+
+    // Чтение колонки через константную ссылку не сбрасывает ее сортированность
+    const VectorLegacySoA<int, double, string>& frozen = records;
+    double sum = 0;
+    for (double x : frozen.column<1>()) {
+        sum += x;
+    }
+    assert(sum > 1.09 && sum < 1.11);
+    assert(frozen.column<0>().sorted() && frozen.column<0>().sorted());
+    assert(records.column<0>().sorted() && !frozen.column<0>().sorted());
+
+    records.delete_(1);
+    assert(records.size() == 3 && records.at<0>(1) == 3 && records.at<2>(1) == "c");
+    records.sort_by<2>();
+    assert(records.at<2>(0) == "a" && records.at<0>(2) == 5);
+    records.delete_(0, 2);
+    assert(records.size() == 1 && records.at<1>(0) == 0.5);
+
+    cout << "SoA tests passed!" << endl;
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <algorithm>
+#include <stdexcept>
+#include <stdlib.h>
+#include <type_traits>
+#include "VectorLegacyKernels.h"
+/*
+Невладеющий срез массива: указатель, длина и флаг сортированности.
+Не выделяет память и ничего не копирует, поэтому срезы одного массива можно раздать
+разным потокам и обрабатывать независимо (если срезы не пересекаются).
+Срез действителен, пока массив не перевыделил память (push_back, insert и т.п.).
+Для константного массива срез имеет тип VectorLegacyView<const T> и доступен только для чтения.
+Сортировка и поиск -- общие с VectorLegacy алгоритмы из VectorLegacyKernels.h.
+*/
+template <typename T>
+class VectorLegacyView {
+private:
+    // Начало среза
+    T* m_data;
+    // Размер среза
+    size_t m_size;
+    // Сортирован ли срез?
+    bool m_sorted;
+
+    // Тип элемента без const -- для временных значений
+    typedef typename std::remove_const<T>::type value_type;
+
+    // Числовые типы -- интерполяционный поиск
+    size_t seek_sorted(const value_type& value, std::true_type) const {
+        return seek_interpol(value);
+    }
+
+    // Для остальных типов разность значений не определена -- бинарный поиск
+    size_t seek_sorted(const value_type& value, std::false_type) const {
+        size_t index = lower_bound(value);
+        return index < m_size && m_data[index] == value ? index : m_size;
+    }
+
+public:
+    VectorLegacyView() : m_data(nullptr), m_size(0), m_sorted(false) {
+    }
+
+    VectorLegacyView(T* data, size_t n, bool sorted) : m_data(data), m_size(n), m_sorted(sorted) {
+    }
+
+    // Размер среза
+    size_t size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    bool sorted() const {
+        return m_sorted;
+    }
+
+    // Доступ к элементам через []
+    T& operator[](size_t index) const {
+        if (index >= m_size) {
+            throw std::out_of_range("Tried to access to index out of view size");
+        }
+        return m_data[index];
+    }
+
+    //Указатель на начало среза
+    T* begin() const {
+        return m_data;
+    }
+
+    //Указатель на конец среза
+    T* end() const {
+        return m_data + m_size;
+    }
+
+    //Срез среза: n элементов начиная с index
+    VectorLegacyView slice(size_t index, size_t n) const {
+        if (index > m_size || n > m_size - index) {
+            throw std::out_of_range("Invalid index or count");
+        }
+        return VectorLegacyView(m_data + index, n, m_sorted);
+    }
+
+    //Средний: О(n)
+    //Последовательный поиск
+    size_t seek_sequentional(const value_type& value) const {
+        for (size_t i = 0; i < m_size; ++i) {
+            if (m_data[i] == value) {
+                return i;
+            }
+        }
+        return m_size;
+    }
+
+    //Средний: О(log(log(n))
+    //Интерполяционный поиск в отсортированном срезе. Возвращает size(), если не найдено
+    size_t seek_interpol(const value_type& value) const {
+        if (!m_sorted) {
+            throw std::runtime_error("View is not sorted");
+        }
+        return VectorLegacyKernels::seek_interpol(m_data, m_size, value);
+    }
+
+    //Поиск: для отсортированного среза интерполяционный (числа) или бинарный, иначе последовательный
+    size_t seek(const value_type& value) const {
+        return m_sorted ? seek_sorted(value, typename std::is_arithmetic<value_type>::type()) : seek_sequentional(value);
+    }
+
+    //Средний: О(log(n))
+    //Первая позиция, где элемент не меньше value. Срез должен быть отсортирован
+    size_t lower_bound(const value_type& value) const {
+        if (!m_sorted) {
+            throw std::runtime_error("View is not sorted");
+        }
+        return (size_t)(std::lower_bound(m_data, m_data + m_size, value) - m_data);
+    }
+
+    //Средний: О(log(n)) для отсортированного среза, иначе О(n)
+    //Количество элементов, равных value
+    size_t count(const value_type& value) const {
+        if (m_sorted) {
+            return (size_t)(std::upper_bound(m_data, m_data + m_size, value) - std::lower_bound(m_data, m_data + m_size, value));
+        }
+        size_t result = 0;
+        for (size_t i = 0; i < m_size; ++i) {
+            if (m_data[i] == value) {
+                ++result;
+            }
+        }
+        return result;
+    }
+
+    //Средний: О(n log(n))
+    //Сортирует элементы среза на месте, без дополнительной памяти
+    void sort() {
+        if (m_sorted || m_size < 2) {
+            m_sorted = true;
+            return;
+        }
+        VectorLegacyKernels::sort_quick(m_data, 0, m_size - 1, VectorLegacyKernels::depth_limit(m_size), std::less<value_type>());
+        m_sorted = true;
+    }
+};